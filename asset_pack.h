@@ -0,0 +1,81 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Layout of assets.pak, written by tools/asset_packer.c and mapped by the
+// game at startup:
+//
+//   PackHeader | PackEntry[entryCount] | payloads (16-byte aligned)
+//
+// Images are stored pre-decoded as RGBA8 so they can be handed to
+// LoadTextureFromImage straight from the mapping. Everything else (music,
+// fonts) is stored as the original file bytes.
+
+#define PACK_MAGIC 0x4B504441u // "ADPK"
+#define PACK_VERSION 1
+#define PACK_NAME_LENGTH 48
+#define PACK_ALIGNMENT 16
+#define PACK_FILE_NAME "assets.pak"
+
+typedef enum
+{
+    PACK_RAW = 0,  // file bytes as-is
+    PACK_RGBA8 = 1 // width * height * 4 bytes of pixels
+} PackPayloadKind;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+} PackHeader;
+
+typedef struct
+{
+    char name[PACK_NAME_LENGTH];
+    uint32_t kind;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t offset; // from the start of the file
+    uint64_t size;
+} PackEntry;
+
+typedef struct
+{
+    const char *name;
+    bool isImage;
+    bool required;
+} PackManifestEntry;
+
+// Every file the game loads at runtime. Optional entries are referenced by
+// the game but are not shipped yet; the game falls back to defaults.
+static const PackManifestEntry PACK_MANIFEST[] = {
+    {"protester.png", true, true},
+    {"protester2.png", true, true},
+    {"protestersRun1.png", true, true},
+    {"protestersRun2.png", true, true},
+    {"protestersRun3.png", true, true},
+    {"police.png", true, true},
+    {"police2.png", true, true},
+    {"policeRun1.png", true, true},
+    {"policeRun2.png", true, true},
+    {"policeRun3.png", true, true},
+    {"bus.png", true, true},
+    {"car.png", true, true},
+    {"tear_gas.png", true, true},
+    {"agitator.png", true, true},
+    {"bg2.png", true, true},
+    {"dhaka_skyline.png", true, false},
+    {"bottom_building.png", true, true},
+    {"helicopter.png", true, true},
+    {"pixel_font.ttf", false, false},
+    {"street_ambience.mp3", false, true},
+};
+
+#define PACK_MANIFEST_COUNT (int)(sizeof(PACK_MANIFEST) / sizeof(PACK_MANIFEST[0]))
+
+#endif // ASSET_PACK_H
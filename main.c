@@ -1,17 +1,326 @@
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
+#include "asset_pack.h"
+#include "platform.h"
+#include "telemetry.h"
+#include "spectator.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
-#define MAX_PROTESTERS 100
-#define MAX_PROJECTILES 200
-#define MAX_POLICE 20
+// Default pool capacities, overridable at runtime through the scenario
+#define DEFAULT_PROTESTERS 100
+#define DEFAULT_PROJECTILES 200
+#define DEFAULT_POLICE 20
 #define MAX_BARRICADES 0
-#define MAX_GAS 5
+#define DEFAULT_GAS 5
+#define DEFAULT_WORLD_WIDTH 1600
+#define MAX_SCENARIO_WAVES 64
+#define SPAWN_BUDGET 250 // wave arrivals placed per tick, so a large wave streams in
+#define WORLD_HEIGHT 900
+#define FIELD_TOP 318    // walkable band of the street
+#define FIELD_BOTTOM 724
+#define FIELD_MARGIN 16
+#define PROTESTER_MAX_SPEED 7.5f // fleeing speed cap, the fastest a protester moves
+#define CAMERA_MIN_ZOOM 0.25f
+#define CAMERA_MAX_ZOOM 2.0f
+#define CAMERA_PAN_SPEED 900.0f
+#define CULL_MARGIN 80.0f      // covers the largest sprite and slogan bubble
+#define IMPOSTOR_CELL 8              // world pixels per crowd impostor texel
+#define IMPOSTOR_BODY_CELLS 5        // texels a protester covers vertically
+#define IMPOSTOR_TOP (FIELD_TOP - (IMPOSTOR_BODY_CELLS / 2 + 1) * IMPOSTOR_CELL)
+#define IMPOSTOR_COUNT_ON 800        // visible protesters that switch the impostor on...
+#define IMPOSTOR_COUNT_OFF 640       // ...and back off
+#define IMPOSTOR_ZOOM 0.5f           // at or below this zoom it is always on
+#define IMPOSTOR_FOCUS_INNER 90.0f   // screen pixels around the cursor kept as full sprites
+#define IMPOSTOR_FOCUS_OUTER 160.0f  // sprites fade into the impostor out to here
+#define POLICE_GRID_CELL 128.0f // bucket size for nearest-officer queries
+#define BG_TILE_WIDTH 320
+#define BG_TILES_PER_SECTION 5 // one background image spans DEFAULT_WORLD_WIDTH
+#define BG_SOURCE_COUNT 2
+#define BG_MAX_RESIDENT_TILES 32
+#define BG_UPLOADS_PER_FRAME 2
 #define GAME_DURATION 300.0f // 5 minutes
-#define POLICE_COUNT MAX_POLICE
+#define FRAME_ARENA_MIN_SIZE (256 * 1024)
+#define ARENA_ALIGNMENT 16
+#define MAX_ASSET_JOBS 64
+#define ASSET_UPLOAD_BUDGET 0.004 // seconds of GPU upload work per frame while loading
+#define TIMER_TICK_RATE 60 // timer wheel resolution, ticks per second
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 3 // 64 ticks, 64^2 ticks, 64^3 ticks (about 72 minutes)
+#define STONE_COOLDOWN 0.2f
+#define POLICE_SHOT_COOLDOWN 2.5f
+#define FLEE_DURATION 5.0f
+#define SURGE_INTERVAL 45.0f
+#define SURGE_DURATION 15.0f
+#define CONTROL_HOLD_TIME 10.0f
+#define SQUAD_SIZE 5              // officers per squad, by slot
+#define SQUAD_PLAN_INTERVAL 0.25f // seconds between a squad's planning passes
+#define SQUAD_SPACING 28.0f       // between officers in a line
+#define SQUAD_PERCEPTION 220.0f   // radius a squad watches around its centroid
+#define MAX_WORKER_THREADS 64
+#define DEFAULT_WORKER_THREADS 8
+#define CROWD_AGENT_RADIUS 6.0f    // protesters never overlap closer than two radii
+#define CROWD_POLICE_RADIUS 10.0f
+#define CROWD_PERSONAL_SPACE 40.0f // closest a protester who is not rioting gets to an officer
+#define CROWD_RELAXATION 1.5f      // over-relaxation of the averaged Jacobi corrections
+#define CROWD_DEFAULT_ITERATIONS 4
+#define CROWD_CHUNK 256            // agents per solver task
+#define AUDIO_MAX_VOICES 12     // one-shots mixed at once, however many are requested
+#define AUDIO_QUEUE_SIZE 64     // commands buffered for the audio thread
+#define AUDIO_SAMPLE_RATE 22050 // synthesized effects, mono 16-bit
+#define AUDIO_PERIOD_MS 5       // the audio thread feeds the music stream at least this often
+#define AUDIO_RANGE 1.5f        // half-views from the listener at which a sound falls silent
+#define AUDIO_MIN_GAIN 0.02f    // quieter requests are dropped before they reach the thread
+#define MUSIC_FILE_NAME "street_ambience.mp3"
+#define PARTICLE_CAPACITY 131072 // live visual particles, allocated once
+#define PARTICLE_DRAG 2.5f       // velocity decay per second
+#define REWIND_MEMORY (64u << 20) // bytes of compressed history kept for rewinding
+#define REWIND_INTERVAL 0.1f       // seconds of play between captures
+#define REWIND_MAX_ENTRIES 600     // one minute at REWIND_INTERVAL
+#define REWIND_KEYFRAME_INTERVAL 50 // captures per keyframe; the rest are deltas
+#define RECORD_BUFFERS 8         // frames being read back or encoded at once
+#define RECORD_ENCODER_THREADS 2
+#define LATENCY_WINDOW 120        // frames summarized by the overlay
+#define LATENCY_LOG_INTERVAL 10.0 // seconds between latency lines in the log
+#define LATENCY_MARGIN 0.002      // low-latency mode: slack kept before a present is due, seconds
+#define LATENCY_MAX_CATCHUP 4     // fixed ticks a late frame may run
+#define VEHICLE_CAPACITY 32
+#define VEHICLE_LANE_COUNT 3
+#define VEHICLE_LANE_SPACING 400.0f // between lane spline control points
+#define VEHICLE_SPAWN_INTERVAL 8    // mean seconds between arrivals in a lane
+#define VEHICLE_GAP 40.0f           // kept to the vehicle ahead
+#define VEHICLE_BRAKING 200.0f      // speed change per second
+#define VEHICLE_VANS 3              // police vans parked as a barricade per surge
+#define VEHICLE_OFFSCREEN 100.0f    // furthest a vehicle's centre gets past the world edge
+#define SWEEP_TICK_RATE 60 // fixed simulation rate of headless matches
+#define BOT_DEFAULT_SELECT_RATE 40 // per minute; every fourth selection is select-all
+#define BOT_DEFAULT_ORDER_RATE 120
+#define BOT_DEFAULT_VOLLEY_RATE 60
+#define BOT_DEFAULT_RETREAT_RATE 4
 
-float police_cooldown[MAX_POLICE];
+// Linear (bump) allocator. Allocations are never freed individually;
+// the whole arena is released at once with ArenaReset.
+typedef struct
+{
+    unsigned char *base;
+    size_t capacity;
+    size_t used;
+    size_t highWater;
+} Arena;
+
+bool ArenaInit(Arena *arena, size_t capacity)
+{
+    arena->base = (unsigned char *)malloc(capacity);
+    arena->capacity = (arena->base != NULL) ? capacity : 0;
+    arena->used = 0;
+    arena->highWater = 0;
+    return arena->base != NULL;
+}
+
+void *ArenaAlloc(Arena *arena, size_t size)
+{
+    size_t offset = (arena->used + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (offset + size > arena->capacity) {
+        TraceLog(LOG_WARNING, "ARENA: Out of memory (%zu of %zu bytes used, %zu requested)", arena->used, arena->capacity, size);
+        return NULL;
+    }
+    arena->used = offset + size;
+    if (arena->used > arena->highWater) arena->highWater = arena->used;
+    return arena->base + offset;
+}
+
+void *ArenaAllocZeroed(Arena *arena, size_t size)
+{
+    void *ptr = ArenaAlloc(arena, size);
+    if (ptr != NULL) memset(ptr, 0, size);
+    return ptr;
+}
+
+void ArenaReset(Arena *arena)
+{
+    arena->used = 0;
+}
+
+void ArenaFree(Arena *arena)
+{
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+// Fixed set of workers that run a batch of indexed tasks. The caller of
+// RunParallel works through the batch too and returns once all of it is done.
+typedef void (*ParallelTask)(void *context, int index);
+
+typedef struct
+{
+    pthread_t threads[MAX_WORKER_THREADS];
+    int threadCount;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned int batch; // bumped for every RunParallel call
+    bool stopping;
+    ParallelTask task;
+    void *context;
+    int count;
+    atomic_int next;
+    atomic_int finished;
+} ThreadPool;
+
+static void RunPoolTasks(ThreadPool *pool)
+{
+    for (;;) {
+        int index = atomic_fetch_add(&pool->next, 1);
+        if (index >= pool->count) break;
+        pool->task(pool->context, index);
+        if (atomic_fetch_add(&pool->finished, 1) + 1 == pool->count) {
+            pthread_mutex_lock(&pool->lock);
+            pthread_cond_signal(&pool->done);
+            pthread_mutex_unlock(&pool->lock);
+        }
+    }
+}
+
+static void *ThreadPoolWorker(void *arg)
+{
+    ThreadPool *pool = (ThreadPool *)arg;
+    unsigned int seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->batch == seen) pthread_cond_wait(&pool->wake, &pool->lock);
+        if (pool->stopping) break;
+        seen = pool->batch;
+        pthread_mutex_unlock(&pool->lock);
+        RunPoolTasks(pool);
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// `threads` counts the caller, so 1 runs every task on the calling thread
+void StartThreadPool(ThreadPool *pool, int threads)
+{
+    memset(pool, 0, sizeof(ThreadPool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    atomic_init(&pool->next, 0);
+    atomic_init(&pool->finished, 0);
+    if (threads > MAX_WORKER_THREADS) threads = MAX_WORKER_THREADS;
+    for (int i = 0; i + 1 < threads; i++) {
+        if (pthread_create(&pool->threads[pool->threadCount], NULL, ThreadPoolWorker, pool) != 0) break;
+        pool->threadCount++;
+    }
+}
+
+// With no pool the tasks simply run in order on the calling thread
+void RunParallel(ThreadPool *pool, int count, ParallelTask task, void *context)
+{
+    if (count <= 0) return;
+    if (pool == NULL) {
+        for (int i = 0; i < count; i++) task(context, i);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    atomic_store(&pool->finished, 0);
+    atomic_store(&pool->next, 0);
+    pool->batch++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    RunPoolTasks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->finished) < count) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void StopThreadPool(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->threadCount; i++) pthread_join(pool->threads[i], NULL);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+// Agents of one faction arriving in an x band of the field. Waves at time 0
+// are the starting forces; negative x counts back from the right edge.
+typedef struct
+{
+    float time;  // seconds into the match
+    int faction; // Faction
+    int count;
+    float minX;
+    float maxX;
+} SpawnWave;
+
+typedef struct
+{
+    int maxProtesters;
+    int maxPolice;
+    int maxProjectiles;
+    int maxGas;
+    int worldWidth;
+    SpawnWave waves[MAX_SCENARIO_WAVES]; // ordered by time
+    int waveCount;
+    const char *telemetryPath; // NULL disables recording
+    const char *recordPath;    // video capture: a .y4m file, or a prefix for numbered PNGs; NULL disables it
+    int telemetryRate;
+    int spectatorPort; // 0 disables the spectator stream
+    unsigned int seed; // GameRandom seed, 0 picks one from the clock
+    int botCrowd;      // >0 hands input to a SyntheticPlayer selecting about this many at a time
+    int botSelectRate; // bot actions per minute
+    int botOrderRate;
+    int botVolleyRate;
+    int botRetreatRate;
+    int sweepMatches;  // >0 runs that many headless matches instead of the game
+    int threads;       // worker threads: parallel matches in a sweep, the crowd solver otherwise
+    int crowdIterations;
+    bool lowLatency;   // polls input late and steps fixed ticks (windowed play)
+} ScenarioConfig;
+
+ScenarioConfig DefaultScenario(void)
+{
+    ScenarioConfig scenario = {
+        .maxProtesters = DEFAULT_PROTESTERS,
+        .maxPolice = DEFAULT_POLICE,
+        .maxProjectiles = DEFAULT_PROJECTILES,
+        .maxGas = DEFAULT_GAS,
+        .worldWidth = DEFAULT_WORLD_WIDTH,
+        .telemetryPath = NULL,
+        .recordPath = NULL,
+        .telemetryRate = TELEMETRY_DEFAULT_RATE,
+        .spectatorPort = 0,
+        .seed = 0,
+        .botCrowd = 0,
+        .botSelectRate = BOT_DEFAULT_SELECT_RATE,
+        .botOrderRate = BOT_DEFAULT_ORDER_RATE,
+        .botVolleyRate = BOT_DEFAULT_VOLLEY_RATE,
+        .botRetreatRate = BOT_DEFAULT_RETREAT_RATE,
+        .sweepMatches = 0,
+        .threads = DEFAULT_WORKER_THREADS,
+        .crowdIterations = CROWD_DEFAULT_ITERATIONS
+    };
+    return scenario;
+}
 
 typedef enum
 {
@@ -30,21 +339,37 @@ typedef struct
     float morale;
     int group_id;
     Vector2 target_pos;
-    float behavior_timer;
-    float animation_timer;
     bool is_agitator;
     bool alive;
-    Texture2D sprite; // legacy single sprite
-    Texture2D sprites[2];    // idle/chant animation frames
-    Texture2D run_sprites[3]; // riot/flee animation frames
-    int anim_frame;
-    float anim_timer;
+    unsigned char anim_phase; // offset into the walk cycle, 0..127
     bool face_right;
-    float stoneCooldown; // seconds left until can throw again
-    float distance;
-    float max_distance;
 } Protester;
 
+// Quantized copy of the fields the per-tick scans read. Positions are 16-bit
+// fixed point across the field, velocity spans +-PROTESTER_MAX_SPEED and
+// morale 0..100 maps to 0..255. Protester stays authoritative; the mirror
+// is re-encoded once per tick so neighbour and target searches over a large
+// crowd walk a dense array instead of the full structs.
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    int8_t vx;
+    int8_t vy;
+    uint8_t morale;
+    uint8_t flags; // bits 0-2 state, then alive, agitator, facing right
+    uint8_t anim_phase;
+    uint8_t group;
+    uint16_t reserved;
+} PackedProtester;
+
+_Static_assert(sizeof(PackedProtester) <= 16, "PackedProtester must stay within 16 bytes");
+
+#define PACKED_STATE_MASK 0x07
+#define PACKED_ALIVE 0x08
+#define PACKED_AGITATOR 0x10
+#define PACKED_FACE_RIGHT 0x20
+
 typedef enum
 {
     PATROL,
@@ -59,18 +384,30 @@ typedef struct
     Vector2 pos;
     Vector2 vel;
     PoliceState state;
-    float timer;
     float health;
     bool alive;
-    Texture2D sprite;
     int id; // Add unique id for police
-    Texture2D sprites[2];
-    Texture2D run_sprites[3];
-    int anim_frame;
-    float anim_timer;
+    unsigned char anim_phase;
     bool face_right;
 } Police;
 
+// Officers are grouped by slot: squad s commands police[s * SQUAD_SIZE]
+// onwards and owns a disjoint range of gas slots, shared out when there are
+// fewer slots than squads (FreeGasSlot). A squad plans on its own timer
+// (perception, target, gas, formation); members only steer to their place
+// in the line and shoot at the squad's target.
+typedef struct
+{
+    PoliceState order;
+    Vector2 anchor;   // centre of the line
+    Vector2 facing;   // unit vector the line faces
+    Vector2 waypoint; // patrol destination
+    int targetIndex;  // protester slot the squad fires on, -1 if none
+    int firstGas;
+    int gasCount;
+    double deployEnd;
+} Squad;
+
 typedef struct
 {
     Vector2 pos;
@@ -106,6 +443,115 @@ typedef struct {
     int current_spawn;
 } Helicopter;
 
+// Buses, cars and police vans follow lanes as kinematic bodies: nothing
+// pushes them, they push agents aside and stop projectiles. A parked
+// vehicle is a barricade and holds its place until released.
+typedef enum
+{
+    VEHICLE_BUS,
+    VEHICLE_CAR,
+    VEHICLE_VAN, // police, deployed as a barricade during a surge
+    VEHICLE_KIND_COUNT
+} VehicleKind;
+
+typedef struct
+{
+    VehicleKind kind;
+    bool active;
+    bool parked;
+    int lane;
+    float dir;       // +1 drives right, -1 left
+    float speed;     // current, pixels per second along the lane
+    float stopX;     // a van parks on reaching this x; negative for none
+    Vector2 pos;     // centre of the footprint on the ground
+    Vector2 heading; // unit, direction of travel
+    Vector2 prevPos; // at the start of the tick, for the swept test
+    int contacts;    // agents pushed last tick; a vehicle in a crowd crawls
+} Vehicle;
+
+// Source frames of one faction, loaded CPU-side and packed into the atlas
+typedef struct
+{
+    Image sprites[2];     // idle/chant animation frames
+    Image run_sprites[3]; // riot/flee animation frames
+} SpriteSet;
+
+// All agent frames live in one atlas so the whole crowd draws from a single
+// texture. Rows: protester idle, protester run, police idle, police run;
+// every frame is centered in a cell of the same size.
+typedef enum
+{
+    FACTION_PROTESTER,
+    FACTION_POLICE
+} Faction;
+
+typedef struct
+{
+    SpriteSet protester;
+    SpriteSet police;
+    Texture2D atlas;
+    int cellWidth;
+    int cellHeight;
+    Shader animShader; // picks the frame on the GPU; id 0 = CPU fallback
+    int timeLoc;
+    int cellSizeLoc;
+    Color crowdColor; // mean opaque color of a protester frame, for the impostor
+} GameAssets;
+
+// Gameplay outcomes are recorded as events by the systems that detect them
+// and applied in one place by ApplyGameEvents, so no system mutates shared
+// counters (morale, arrests, health) while iterating.
+typedef enum
+{
+    EVENT_POLICE_HIT,     // target = police, source = protester, amount = damage
+    EVENT_PROTESTER_HIT,  // target = protester, amount = morale damage
+    EVENT_ARREST,         // target = protester, source = police
+    EVENT_GAS_EXPOSURE,   // target = protester, source = gas cloud
+    EVENT_POLICE_DOWN,    // emitted by the reducer when health reaches zero
+    EVENT_PROTESTER_DOWN, // emitted by the reducer when morale reaches zero
+    EVENT_CHANT_HEARD,    // target = protester, amount = morale from chanting neighbours
+    EVENT_CHANT,          // amount = global morale from this tick's chanting
+    EVENT_TYPE_COUNT
+} GameEventType;
+
+typedef enum
+{
+    CAUSE_NONE,
+    CAUSE_MELEE,
+    CAUSE_STONE,
+    CAUSE_BULLET,
+    CAUSE_HELICOPTER,
+    CAUSE_GAS
+} EventCause;
+
+typedef struct
+{
+    unsigned char type;  // GameEventType
+    unsigned char cause; // EventCause
+    int target;
+    int source;
+    float amount;
+    Vector2 impulse;
+} GameEvent;
+
+typedef struct
+{
+    GameEvent *items;
+    int count;
+    int capacity;
+} EventQueue;
+
+#define EVENT_FEED_SIZE 5
+
+typedef struct
+{
+    int totals[EVENT_TYPE_COUNT];   // whole match
+    int lastTick[EVENT_TYPE_COUNT]; // most recent tick only
+    int dropped;
+    const char *feed[EVENT_FEED_SIZE]; // newest first, shown in the HUD
+    double feedTime[EVENT_FEED_SIZE];
+} GameStats;
+
 typedef enum
 {
     MENU_START,
@@ -113,1157 +559,5902 @@ typedef enum
     MENU_PAUSE,
     MENU_WIN,
     MENU_LOSE,
-    MENU_TUTORIAL
+    MENU_TUTORIAL,
+    MENU_LOADING,
+    MENU_REWIND // play frozen while scrubbing the rewind history
 } GameMenu;
 
+// Everything time-driven in a match is a timer. Per-agent kinds have one
+// timer per slot; the rest exist once per match. A cooldown is simply a
+// pending timer, so agents with nothing scheduled cost nothing per tick.
+typedef enum
+{
+    TIMER_STONE_COOLDOWN,  // per protester, blocks throwing while pending
+    TIMER_FLEE_END,        // per protester, FLEE reverts to IDLE
+    TIMER_POLICE_COOLDOWN, // per officer, blocks shooting while pending
+    TIMER_SURGE,           // starts or ends a police surge
+    TIMER_HELICOPTER,      // next helicopter arrival
+    TIMER_MORALE_DECAY,    // recurring global morale loss
+    TIMER_CONTROL_HOLD,    // territory held long enough to win
+    TIMER_SQUAD_PLAN,      // per squad, next planning pass
+    TIMER_WAVE,            // per scenario wave, its arrival
+    TIMER_TRAFFIC,         // per lane, next vehicle
+    TIMER_KIND_COUNT
+} TimerKind;
+
+typedef struct
+{
+    int next; // -1 when not scheduled
+    int prev;
+    uint32_t due; // wheel tick
+    uint8_t kind;
+} TimerNode;
+
+// Hierarchical timer wheel. Level 0 holds timers due within the current
+// 64-tick block, one slot per tick; level 1 those due later in the current
+// 4096-tick block, one slot per 64 ticks; level 2 the rest. A coarse slot
+// is redistributed when its block begins, so scheduling, cancelling and
+// firing are all O(1) per timer. Each slot is a circular list through a
+// sentinel node stored after the timers.
+typedef struct
+{
+    TimerNode *nodes;
+    int count; // timers, excluding sentinels
+    int base[TIMER_KIND_COUNT];
+    uint32_t tick; // last tick processed
+} TimerWheel;
+
+// One tick of player input in world space. The window build fills it from
+// raylib each frame (CaptureInput); headless runs leave it empty.
 typedef struct
 {
-    Protester protesters[MAX_PROTESTERS];
-    Police police[MAX_POLICE];
-    TearGas gas[MAX_GAS];
-    Projectile projectiles[MAX_PROJECTILES];
-    bool selected[MAX_PROTESTERS];
+    double sampledAt; // wall clock of the input poll it came from, 0 if synthetic
+    Vector2 mouseWorld;
+    bool selectPressed; // left button
+    bool selectDown;
+    bool selectReleased;
+    bool commandPressed; // right button
+    bool selectAllPressed; // A
+    bool retreatPressed;   // SPACE
+    bool throwPressed;     // T
+    bool barricadePressed; // B
+} InputState;
+
+// Where a GameState's input comes from. UpdateGame polls it once per tick;
+// with none installed the game sees no input at all.
+typedef struct GameState GameState;
+
+// Positional one-shots raised by the simulation, mixed by the audio thread
+typedef enum
+{
+    SFX_STONE,
+    SFX_BULLET,
+    SFX_GAS,
+    SFX_ARREST,
+    SFX_HELICOPTER,
+    SFX_COUNT
+} SoundEffect;
+
+typedef struct AudioSystem AudioSystem;
+
+// Visual-only particle bursts, see the particle section
+typedef enum
+{
+    PARTICLES_DUST,   // stone impact
+    PARTICLES_MUZZLE, // police shot
+    PARTICLES_WASH,   // under the helicopter, every tick it flies
+    PARTICLES_GAS,    // canister deployed
+    PARTICLE_EFFECT_COUNT
+} ParticleEffect;
+
+typedef struct ParticleSystem ParticleSystem;
+typedef struct InputSource InputSource;
+struct InputSource
+{
+    void (*poll)(InputSource *source, const GameState *game, InputState *input);
+};
+
+struct GameState
+{
+    ScenarioConfig scenario;
+    double time;    // simulation clock, advanced only by UpdateGame
+    float dt;       // length of the current tick
+    uint64_t rng;   // GameRandom state, seeded from the scenario
+    InputSource *inputSource;
+    InputState input; // this tick's, filled from inputSource
+    ThreadPool *workers; // NULL runs parallel systems on the simulation thread
+    AudioSystem *audio;  // NULL when headless; sounds are then not raised at all
+    ParticleSystem *particles; // NULL when headless, likewise
+    int maxProtesters;
+    int maxPolice;
+    int maxProjectiles;
+    int maxGas;
+    float worldWidth;
+    Camera2D camera;
+    Protester *protesters;
+    PackedProtester *crowd; // quantized mirror of protesters, see PackCrowd
+    Police *police;
+    Squad *squads;
+    int squadCount;
+    TearGas *gas;
+    Projectile *projectiles;
+    Helicopter helicopter;
+    Vehicle *vehicles; // VEHICLE_CAPACITY slots
+    float *laneY;      // lane spline control points, lanePoints per lane
+    int lanePoints;
+    TimerWheel timers;
+    uint64_t *selected; // one bit per protester slot
+    Arena poolArena;  // entity pools, sized once from the scenario
+    Arena frameArena; // transient per-frame data (draw lists, queries)
+    float animTime;    // clock for sprite animation, advances only while playing
+    float systemTime[TIMING_COUNT]; // ms per system, summed until telemetry samples it
+    int timedTicks;
+    EventQueue events; // this tick's events, allocated from frameArena
+    GameStats stats;
     bool isSelecting;
     Vector2 selectStart, selectEnd;
     float globalMorale;
-    double lastMoraleTime;
     double gameStartTime;
-    double policeSurgeTimer;
     bool policeSurgeActive;
     double policeSurgeEnd;
     GameMenu menuState;
     int protesterCount;
     int policeCount;
+    int protesterArrivals;  // protesters spawned this match, the base of the lose threshold
+    int waveRemaining[MAX_SCENARIO_WAVES]; // arrived agents still waiting for a slot
+    int spawnCursor[2];     // per Faction, where the search for a free slot resumes
     float controlProgress;
     double controlStartTime;
     int protesters_arrested;
     float max_morale_reached;
-} GameState;
+};
 
-Helicopter helicopter;
+void PlayGameSound(GameState *game, SoundEffect effect, Vector2 pos);
+void EmitParticles(GameState *game, ParticleEffect effect, Vector2 pos, Vector2 dir);
 
-void InitHelicopter(GameState *game) {
-    helicopter.active = 0;
-    helicopter.current_spawn = 0;
-    for (int i = 0; i < 3; i++) {
-        helicopter.spawn_times[i] = GetRandomValue(0, 300);
-    }
-    for (int i = 0; i < 2; i++) {
-        for (int j = i+1; j < 3; j++) {
-            if (helicopter.spawn_times[i] > helicopter.spawn_times[j]) {
-                float temp = helicopter.spawn_times[i];
-                helicopter.spawn_times[i] = helicopter.spawn_times[j];
-                helicopter.spawn_times[j] = temp;
-            }
-        }
-    }
-    for (int i = 1; i < 3; i++) {
-        if (helicopter.spawn_times[i] - helicopter.spawn_times[i-1] < 30.0f) {
-            helicopter.spawn_times[i] += 30.0f;
-            if (helicopter.spawn_times[i] > 300.0f) helicopter.spawn_times[i] = 300.0f;
-        }
+typedef struct {
+    float y;
+    int type; // 1 = protester, 2 = police
+    int index;
+    unsigned char alpha; // below 255 while fading into the crowd impostor
+} DrawEntity;
+
+// Pre-rendered layers. The screen-space foreground never changes during a
+// match, so it is composed once at native resolution; the HUD panel is
+// redrawn into its layer only when one of its values changes. The world
+// background is streamed in tiles around the camera.
+#define HUD_LAYER_HEIGHT 170
+#define TARGET_FPS 60
+#define FRAME_BUDGET (1.0 / TARGET_FPS)
+#define WORLD_SCALE_MIN 0.5f
+#define WORLD_SCALE_STEP 0.125f
+#define WORLD_SCALE_SETTLE 30    // frames to wait after a change before judging it
+#define WORLD_SCALE_HEADROOM 120 // frames well under budget before scaling back up
+
+typedef struct
+{
+    int morale10;      // globalMorale in tenths
+    int timeLeft;      // whole seconds
+    int protesters;
+    int arrested;
+    int control10;     // territory control in tenths of a percent
+    int controlTime10; // seconds of held control in tenths
+    int police;
+    int surge10;       // seconds of surge left in tenths, -1 if none
+} HudSnapshot;
+
+typedef struct
+{
+    int index; // tile column in the world, -1 if the slot is free
+    Texture2D texture;
+    unsigned int lastUsed;
+} BackgroundTile;
+
+// The street background is cut into BG_TILE_WIDTH columns generated from
+// CPU-side source images; only columns near the camera are kept on the GPU.
+typedef struct
+{
+    Image sources[BG_SOURCE_COUNT]; // alternated section by section
+    int sourceCount;
+    BackgroundTile tiles[BG_MAX_RESIDENT_TILES];
+    unsigned int frame;
+} BackgroundStreamer;
+
+typedef struct
+{
+    BackgroundStreamer background;
+    RenderTexture2D foreground;
+    RenderTexture2D hud;
+    bool staticReady;
+    bool hudValid;
+    HudSnapshot hudShown;
+    RenderTexture2D world; // screen-sized; the world is drawn into its lower-left worldScale part
+    float worldScale;
+    double frameWork;      // smoothed seconds of work per frame, excluding pacing
+    int settleFrames;
+    int headroomFrames;
+    Texture2D crowd;       // impostor over the field, one texel per IMPOSTOR_CELL; created on first use
+    uint32_t *crowdAccum;  // per texel: weight, then red, green and blue sums
+    Color *crowdPixels;    // staging for the visible columns
+    int crowdColumns;
+    int crowdRows;
+    bool crowdImpostor;    // dense crowds are splatted instead of drawn one by one
+} LayerCache;
+
+// xorshift64* stream owned by one GameState, so matches stay independent of
+// each other and replay exactly from their seed. Same range contract as
+// raylib's GetRandomValue: both bounds inclusive.
+int NextRandom(uint64_t *state, int min, int max)
+{
+    if (min > max) {
+        int swap = min;
+        min = max;
+        max = swap;
     }
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    uint64_t span = (uint64_t)((int64_t)max - min + 1);
+    return min + (int)(((x * 0x2545F4914F6CDD1Dull) >> 32) % span);
 }
 
-void UpdateHelicopter(GameState *game, float dt) {
-    double timer = GetTime() - game->gameStartTime;
-    if (timer >= 300.0f) return;
-    if (!helicopter.active && helicopter.current_spawn < 3 && timer >= helicopter.spawn_times[helicopter.current_spawn]) {
-        helicopter.active = 1;
-        helicopter.pos = (Vector2){1600 + 32, 50.0f};
-        helicopter.vel = (Vector2){-4.0f, 0.0f};
-        helicopter.appear_timer = GetRandomValue(10, 20);
-        helicopter.shots_fired = 0;
-        helicopter.shot_cooldown = 0.0f;
-        helicopter.current_spawn++;
-    }
-    if (helicopter.active) {
-        helicopter.pos.x += helicopter.vel.x;
-        helicopter.pos.y += sinf(timer * 2.0f) * 0.5f;
-        helicopter.appear_timer -= dt;
-        helicopter.shot_cooldown -= dt;
-        int shot_limit = 4;
-        if (helicopter.pos.x < -32 || helicopter.shots_fired >= shot_limit) {
-            helicopter.active = 0;
-            return;
-        }
-        if (helicopter.shot_cooldown <= 0) {
-            int target_idx = -1;
-            for (int tries = 0; tries < 10; tries++) {
-                int j = GetRandomValue(0, MAX_PROTESTERS - 1);
-                if (game->protesters[j].alive && game->protesters[j].state == RIOT) {
-                    target_idx = j;
-                    break;
-                }
-            }
-            if (target_idx == -1) {
-                for (int j = 0; j < MAX_PROTESTERS; j++) {
-                    if (game->protesters[j].alive) {
-                        target_idx = j;
-                        break;
-                    }
-                }
-            }
-            if (target_idx != -1) {
-                Vector2 target = game->protesters[target_idx].pos;
-                for (int i = 0; i < MAX_PROJECTILES; i++) {
-                    if (!game->projectiles[i].active) {
-                        game->projectiles[i].pos = helicopter.pos;
-                        Vector2 dir = Vector2Normalize(Vector2Subtract(target, helicopter.pos));
-                        game->projectiles[i].vel = Vector2Scale(dir, 400.0f);
-                        game->projectiles[i].owner_id = -1;
-                        game->projectiles[i].lifetime = 0.0f;
-                        game->projectiles[i].active = 1;
-                        game->projectiles[i].type = HELICOPTER_BULLET;
-                        game->projectiles[i].damage = 100.0f;
-                        game->projectiles[i].distance = 0.0f;
-                        game->projectiles[i].max_distance = 1600.0f;
-                        helicopter.shots_fired++;
-                        helicopter.shot_cooldown = GetRandomValue(2, 4);
-                        break;
-                    }
-                }
-            }
-        }
-    }
+uint64_t SeedRandom(uint64_t seed)
+{
+    return seed * 0x9E3779B97F4A7C15ull + 1; // never zero for small seeds
 }
 
-void DrawHelicopter(GameState *game, Texture2D helicopterSprite) {
-    if (helicopter.active) {
-        if (helicopterSprite.id != 0) {
-            DrawTexture(helicopterSprite, (int)(helicopter.pos.x - 16), (int)(helicopter.pos.y - 8), WHITE);
-        } else {
-            DrawRectangle((int)(helicopter.pos.x - 16), (int)(helicopter.pos.y - 8), 32, 16, GRAY);
-        }
-    }
+int GameRandom(GameState *game, int min, int max)
+{
+    return NextRandom(&game->rng, min, max);
 }
 
-void InitGame(GameState *game);
-void UpdateGame(GameState *game);
-void UpdateProtesters(GameState *game);
-void ShootBullet(GameState *game, Police* p, Vector2 target);
-void UpdatePolice(GameState *game);
-void UpdateTearGas(GameState *game);
-void HandleInput(GameState *game);
-void DrawGame(GameState *game, Font pixelFont, Texture2D *textures);
-void DrawUI(GameState *game, Font pixelFont, Texture2D *textures);
-bool CheckWinCondition(GameState *game);
-bool CheckLoseCondition(GameState *game);
+void SeedGameRandom(GameState *game, uint64_t seed)
+{
+    game->rng = SeedRandom(seed);
+}
 
-void EnforceProtesterBoundaries(Protester *protester, GameState *game, int index)
+static inline int TimerSentinel(const TimerWheel *wheel, int level, int slot)
 {
-    const float minDistance = 20.0f;
-    Vector2 separation = {0, 0};
-    int sepCount = 0;
+    return wheel->count + level * TIMER_WHEEL_SLOTS + slot;
+}
 
-    for (int j = 0; j < MAX_PROTESTERS; j++)
-    {
-        if (index == j || !game->protesters[j].alive)
-            continue;
+static inline int TimerId(const TimerWheel *wheel, TimerKind kind, int target)
+{
+    return wheel->base[kind] + target;
+}
 
-        float dist = Vector2Distance(protester->pos, game->protesters[j].pos);
-        if (dist < minDistance && dist > 0)
-        {
-            Vector2 diff = Vector2Subtract(protester->pos, game->protesters[j].pos);
-            diff = Vector2Scale(Vector2Normalize(diff), minDistance / (dist + 1));
-            separation = Vector2Add(separation, diff);
-            sepCount++;
-        }
+// `counts` is the number of timers of each kind
+bool InitTimerWheel(TimerWheel *wheel, Arena *arena, const int counts[TIMER_KIND_COUNT])
+{
+    memset(wheel, 0, sizeof(TimerWheel));
+    for (int kind = 0; kind < TIMER_KIND_COUNT; kind++) {
+        wheel->base[kind] = wheel->count;
+        wheel->count += counts[kind];
     }
+    int total = wheel->count + TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS;
+    wheel->nodes = ArenaAlloc(arena, sizeof(TimerNode) * total);
+    if (wheel->nodes == NULL) return false;
+    for (int kind = 0; kind < TIMER_KIND_COUNT; kind++) {
+        for (int i = 0; i < counts[kind]; i++) wheel->nodes[wheel->base[kind] + i].kind = (uint8_t)kind;
+    }
+    return true;
+}
 
-    for (int p = 0; p < MAX_POLICE; p++)
-    {
-        if (!game->police[p].alive)
-            continue;
-        float dist = Vector2Distance(protester->pos, game->police[p].pos);
-        if (protester->state != RIOT && dist < 80.0f && dist > 0)
-        {
-            Vector2 diff = Vector2Subtract(protester->pos, game->police[p].pos);
-            diff = Vector2Scale(Vector2Normalize(diff), 100.0f / (dist + 1));
-            separation = Vector2Add(separation, diff);
-            sepCount++;
-        }
+// Unschedules everything and restarts the wheel at `tick`
+void ResetTimerWheel(TimerWheel *wheel, uint32_t tick)
+{
+    for (int i = 0; i < wheel->count; i++) wheel->nodes[i].next = -1;
+    for (int i = wheel->count; i < wheel->count + TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++) {
+        wheel->nodes[i].next = i;
+        wheel->nodes[i].prev = i;
     }
+    wheel->tick = tick;
+}
 
-    if (sepCount > 0)
-    {
-        separation = Vector2Scale(separation, 1.0f / sepCount);
-        protester->vel = Vector2Add(protester->vel, Vector2Scale(separation, 2.0f));
+static void LinkTimer(TimerWheel *wheel, int id)
+{
+    uint32_t due = wheel->nodes[id].due;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && (due >> (TIMER_WHEEL_BITS * (level + 1))) != (wheel->tick >> (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
     }
+    int head = TimerSentinel(wheel, level, (due >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1));
+    TimerNode *node = &wheel->nodes[id];
+    node->prev = head;
+    node->next = wheel->nodes[head].next;
+    wheel->nodes[node->next].prev = id;
+    wheel->nodes[head].next = id;
 }
 
-void InitGame(GameState *game)
+static void UnlinkTimer(TimerWheel *wheel, int id)
 {
-    memset(game, 0, sizeof(GameState));
+    TimerNode *node = &wheel->nodes[id];
+    wheel->nodes[node->prev].next = node->next;
+    wheel->nodes[node->next].prev = node->prev;
+    node->next = -1;
+}
 
-    game->globalMorale = 50.0f;
-    game->lastMoraleTime = GetTime();
-    game->gameStartTime = GetTime();
-    game->policeSurgeTimer = GetTime();
-    game->menuState = MENU_START;
-    game->protesterCount = MAX_PROTESTERS;
-    game->policeCount = MAX_POLICE;
-
-    for (int i = 0; i < MAX_PROTESTERS; i++) {
-        game->protesters[i].pos = (Vector2){GetRandomValue(50, 300), GetRandomValue(302, 740)};
-        game->protesters[i].vel = (Vector2){0, 0};
-        game->protesters[i].state = (i % 3 == 0) ? CHANT : IDLE;
-        game->protesters[i].morale = GetRandomValue(80, 100);
-        game->protesters[i].is_agitator = (i < 10);
-        game->protesters[i].alive = true;
-        game->protesters[i].group_id = i / 10;
-        game->protesters[i].target_pos = game->protesters[i].pos;
-        game->protesters[i].stoneCooldown = 0.0f;
-        game->protesters[i].distance = 0.0f;
-        game->protesters[i].max_distance = 320.0f;
-        game->protesters[i].anim_frame = 0;
-        game->protesters[i].anim_timer = 0.0f;
-        game->protesters[i].face_right = true;
-        game->protesters[i].sprites[0] = LoadTexture("protester.png");
-        game->protesters[i].sprites[1] = LoadTexture("protester2.png");
-        game->protesters[i].run_sprites[0] = LoadTexture("protestersRun1.png");
-        game->protesters[i].run_sprites[1] = LoadTexture("protestersRun2.png");
-        game->protesters[i].run_sprites[2] = LoadTexture("protestersRun3.png");
-        for (int j = 0; j < 2; j++) if (game->protesters[i].sprites[j].id != 0) SetTextureFilter(game->protesters[i].sprites[j], TEXTURE_FILTER_POINT);
-        for (int j = 0; j < 3; j++) if (game->protesters[i].run_sprites[j].id != 0) SetTextureFilter(game->protesters[i].run_sprites[j], TEXTURE_FILTER_POINT);
-    }
-
-    for (int i = 0; i < MAX_POLICE; i++) {
-        game->police[i].pos = (Vector2){GetRandomValue(1200, 1500), GetRandomValue(302, 740)};
-        game->police[i].vel = (Vector2){0, 0};
-        game->police[i].state = PATROL;
-        game->police[i].timer = 0.0f;
-        game->police[i].health = 100.0f;
-        game->police[i].alive = true;
-        game->police[i].id = i;
-        game->police[i].sprites[0] = LoadTexture("police.png");
-        game->police[i].sprites[1] = LoadTexture("police2.png");
-        game->police[i].run_sprites[0] = LoadTexture("policeRun1.png");
-        game->police[i].run_sprites[1] = LoadTexture("policeRun2.png");
-        game->police[i].run_sprites[2] = LoadTexture("policeRun3.png");
-        for (int j = 0; j < 2; j++) if (game->police[i].sprites[j].id != 0) SetTextureFilter(game->police[i].sprites[j], TEXTURE_FILTER_POINT);
-        for (int j = 0; j < 3; j++) if (game->police[i].run_sprites[j].id != 0) SetTextureFilter(game->police[i].run_sprites[j], TEXTURE_FILTER_POINT);
-        game->police[i].anim_frame = 0;
-        game->police[i].anim_timer = 0.0f;
-        game->police[i].face_right = true;
-        police_cooldown[i] = 0.0f;
-    }
-
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        game->projectiles[i].active = false;
-        game->projectiles[i].lifetime = 0.0f;
-        game->projectiles[i].owner_id = -1;
-        game->projectiles[i].pos = (Vector2){0,0};
-        game->projectiles[i].vel = (Vector2){0,0};
-        game->projectiles[i].distance = 0.0f;
-        game->projectiles[i].max_distance = 320.0f;
-    }
+static inline bool TimerPending(const GameState *game, TimerKind kind, int target)
+{
+    return game->timers.nodes[TimerId(&game->timers, kind, target)].next != -1;
+}
 
-    InitHelicopter(game);
+void CancelTimer(GameState *game, TimerKind kind, int target)
+{
+    int id = TimerId(&game->timers, kind, target);
+    if (game->timers.nodes[id].next != -1) UnlinkTimer(&game->timers, id);
 }
 
-void UpdateProtesters(GameState *game)
+// (Re)schedules a timer to fire `seconds` from now, at least one tick ahead
+void ScheduleTimer(GameState *game, TimerKind kind, int target, float seconds)
 {
-    int chantingCount = 0;
-    int activeProtesters = 0;
-    for (int i = 0; i < MAX_PROTESTERS; i++) {
-        Protester *p = &game->protesters[i];
-        if (!p->alive || p->state == ARRESTED) continue;
-        activeProtesters++;
-        float cycle_time = (p->state == RIOT || p->state == FLEE) ? 0.2f : 0.4f;
-        p->anim_timer += GetFrameTime();
-        int frame_count = (p->state == RIOT || p->state == FLEE) ? 3 : 2;
-        if (p->anim_timer >= cycle_time) {
-            p->anim_frame = (p->anim_frame + 1) % frame_count;
-            p->anim_timer = 0.0f;
-        }
-        p->face_right = (p->vel.x >= 0);
+    TimerWheel *wheel = &game->timers;
+    int id = TimerId(wheel, kind, target);
+    if (wheel->nodes[id].next != -1) UnlinkTimer(wheel, id);
+    uint32_t ticks = (seconds > 0.0f) ? (uint32_t)(seconds * TIMER_TICK_RATE + 0.5f) : 0;
+    uint32_t limit = (TIMER_WHEEL_SLOTS - 1) << (TIMER_WHEEL_BITS * (TIMER_WHEEL_LEVELS - 1));
+    if (ticks < 1) ticks = 1;
+    if (ticks > limit) ticks = limit;
+    wheel->nodes[id].due = wheel->tick + ticks;
+    LinkTimer(wheel, id);
+}
 
-        if (p->stoneCooldown > 0.0f) {
-            p->stoneCooldown -= GetFrameTime();
-            if (p->stoneCooldown < 0.0f) p->stoneCooldown = 0.0f;
-        }
+// 16-bit fixed point over [min, max], shared by the crowd mirror and the
+// spectator stream
+static inline uint16_t QuantizeRange(float value, float min, float max)
+{
+    return (uint16_t)(Clamp((value - min) / (max - min), 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
 
-        Vector2 targetForce = {0, 0};
-        if (Vector2Distance(p->pos, p->target_pos) > 10.0f) {
-            targetForce = Vector2Scale(Vector2Normalize(Vector2Subtract(p->target_pos, p->pos)), 0.8f);
-        }
+static inline float DequantizeRange(uint16_t value, float min, float max)
+{
+    return min + value * ((max - min) / 65535.0f);
+}
 
-        Vector2 stateForce = {0, 0};
-        float speedMultiplier = 1.0f;
-        switch (p->state) {
-            case CHANT:
-                chantingCount++;
-                speedMultiplier = 0.1f;
-                for (int j = 0; j < MAX_PROTESTERS; j++) {
-                    if (i != j && game->protesters[j].alive && Vector2Distance(p->pos, game->protesters[j].pos) < 60.0f) {
-                        game->protesters[j].morale += 0.1f;
-                    }
+PackedProtester EncodeProtester(const Protester *p, float worldWidth)
+{
+    PackedProtester packed = {0};
+    packed.x = QuantizeRange(p->pos.x, 0.0f, worldWidth);
+    packed.y = QuantizeRange(p->pos.y, FIELD_TOP, FIELD_BOTTOM);
+    packed.vx = (int8_t)roundf(Clamp(p->vel.x / PROTESTER_MAX_SPEED, -1.0f, 1.0f) * 127.0f);
+    packed.vy = (int8_t)roundf(Clamp(p->vel.y / PROTESTER_MAX_SPEED, -1.0f, 1.0f) * 127.0f);
+    packed.morale = (uint8_t)(Clamp(p->morale, 0.0f, 100.0f) * 2.55f + 0.5f);
+    packed.flags = (uint8_t)(p->state & PACKED_STATE_MASK);
+    if (p->alive) packed.flags |= PACKED_ALIVE;
+    if (p->is_agitator) packed.flags |= PACKED_AGITATOR;
+    if (p->face_right) packed.flags |= PACKED_FACE_RIGHT;
+    packed.anim_phase = p->anim_phase;
+    packed.group = (uint8_t)p->group_id;
+    return packed;
+}
+
+Vector2 PackedPosition(PackedProtester packed, float worldWidth)
+{
+    return (Vector2){DequantizeRange(packed.x, 0.0f, worldWidth), DequantizeRange(packed.y, FIELD_TOP, FIELD_BOTTOM)};
+}
+
+static inline bool PackedAlive(PackedProtester packed)
+{
+    return (packed.flags & PACKED_ALIVE) != 0;
+}
+
+static inline ProtesterState PackedState(PackedProtester packed)
+{
+    return (ProtesterState)(packed.flags & PACKED_STATE_MASK);
+}
+
+// Restores the fields a packed protester carries; the rest of *p is kept
+void DecodeProtester(PackedProtester packed, float worldWidth, Protester *p)
+{
+    p->pos = PackedPosition(packed, worldWidth);
+    p->vel = (Vector2){packed.vx * (PROTESTER_MAX_SPEED / 127.0f), packed.vy * (PROTESTER_MAX_SPEED / 127.0f)};
+    p->morale = packed.morale / 2.55f;
+    p->state = PackedState(packed);
+    p->alive = PackedAlive(packed);
+    p->is_agitator = (packed.flags & PACKED_AGITATOR) != 0;
+    p->face_right = (packed.flags & PACKED_FACE_RIGHT) != 0;
+    p->anim_phase = packed.anim_phase;
+    p->group_id = packed.group;
+}
+
+// Re-encodes the whole crowd. Runs once per tick right after the protesters
+// move, so everything that reads them later in the tick (police, gas,
+// projectiles, drawing) sees this tick's positions.
+void PackCrowd(GameState *game)
+{
+    for (int i = 0; i < game->maxProtesters; i++) {
+        game->crowd[i] = EncodeProtester(&game->protesters[i], game->worldWidth);
+    }
+}
+
+static inline int SelectionWords(const GameState *game)
+{
+    return (game->maxProtesters + 63) / 64;
+}
+
+static inline bool IsSelected(const GameState *game, int index)
+{
+    return (game->selected[index >> 6] >> (index & 63)) & 1;
+}
+
+// Starts a new frame: releases last frame's transient memory, including the
+// event buffer.
+void BeginGameFrame(GameState *game)
+{
+    ArenaReset(&game->frameArena);
+    game->events = (EventQueue){0};
+}
+
+// Room for a tick's events: hits, gas and chant morale per protester, hits
+// and downs per officer, one per projectile, and slack
+static int EventQueueCapacity(const GameState *game)
+{
+    return 3 * game->maxProtesters + 2 * game->maxPolice + game->maxProjectiles + 64;
+}
+
+void BeginEventQueue(GameState *game)
+{
+    int capacity = EventQueueCapacity(game);
+    game->events.items = ArenaAlloc(&game->frameArena, sizeof(GameEvent) * capacity);
+    game->events.capacity = (game->events.items != NULL) ? capacity : 0;
+    game->events.count = 0;
+}
+
+// Returns the queued event so callers can fill optional fields, or NULL if
+// the buffer is full
+GameEvent *PushGameEvent(GameState *game, GameEventType type, EventCause cause, int target, int source, float amount)
+{
+    EventQueue *queue = &game->events;
+    if (queue->count >= queue->capacity) {
+        game->stats.dropped++;
+        return NULL;
+    }
+    GameEvent *ev = &queue->items[queue->count++];
+    *ev = (GameEvent){(unsigned char)type, (unsigned char)cause, target, source, amount, {0, 0}};
+    return ev;
+}
+
+void PushFeedMessage(GameStats *stats, const char *message, double now)
+{
+    for (int i = EVENT_FEED_SIZE - 1; i > 0; i--) {
+        stats->feed[i] = stats->feed[i - 1];
+        stats->feedTime[i] = stats->feedTime[i - 1];
+    }
+    stats->feed[0] = message;
+    stats->feedTime[0] = now;
+}
+
+// Single reducer for the tick. Events are applied in queue order; events
+// appended here (the DOWN notifications) are processed in the same pass so
+// the queue ends up as a complete record of the tick.
+void ApplyGameEvents(GameState *game)
+{
+    EventQueue *queue = &game->events;
+    memset(game->stats.lastTick, 0, sizeof(game->stats.lastTick));
+
+    for (int e = 0; e < queue->count; e++) {
+        GameEvent *ev = &queue->items[e];
+        game->stats.totals[ev->type]++;
+        game->stats.lastTick[ev->type]++;
+
+        switch (ev->type) {
+        case EVENT_POLICE_HIT: {
+            Police *pol = &game->police[ev->target];
+            if (!pol->alive) break;
+            pol->health -= ev->amount;
+            pol->vel = Vector2Add(pol->vel, ev->impulse);
+            if (ev->cause == CAUSE_STONE) game->globalMorale += 2.0f;
+            if (pol->health <= 0.0f) {
+                pol->alive = false;
+                game->policeCount--;
+                if (ev->cause == CAUSE_MELEE) game->globalMorale += 3.0f;
+                PushGameEvent(game, EVENT_POLICE_DOWN, ev->cause, ev->target, ev->source, 0.0f);
+            }
+            break;
+        }
+        case EVENT_PROTESTER_HIT: {
+            Protester *pr = &game->protesters[ev->target];
+            if (!pr->alive) break;
+            pr->morale -= ev->amount;
+            if (pr->morale <= 0) {
+                pr->alive = false;
+                game->crowd[ev->target].flags &= ~PACKED_ALIVE; // hidden from scans until the next pack
+                game->protesterCount--;
+                game->globalMorale -= (ev->cause == CAUSE_HELICOPTER) ? 10.0f : 5.0f;
+                PushGameEvent(game, EVENT_PROTESTER_DOWN, ev->cause, ev->target, ev->source, 0.0f);
+            }
+            break;
+        }
+        case EVENT_ARREST: {
+            Protester *pr = &game->protesters[ev->target];
+            if (!pr->alive) break;
+            pr->state = ARRESTED;
+            pr->alive = false;
+            game->crowd[ev->target].flags &= ~PACKED_ALIVE;
+            game->protesterCount--;
+            game->globalMorale -= 5.0f;
+            game->protesters_arrested++;
+            PlayGameSound(game, SFX_ARREST, pr->pos);
+            PushFeedMessage(&game->stats, "Protester arrested", game->time);
+            break;
+        }
+        case EVENT_GAS_EXPOSURE: {
+            Protester *pr = &game->protesters[ev->target];
+            if (!pr->alive || pr->state == FLEE) break;
+            pr->state = FLEE;
+            pr->morale -= 15;
+            ScheduleTimer(game, TIMER_FLEE_END, ev->target, FLEE_DURATION);
+            pr->target_pos = (Vector2){50, pr->pos.y};
+            game->globalMorale -= 0.5f;
+            break;
+        }
+        case EVENT_POLICE_DOWN:
+            PushFeedMessage(&game->stats, (ev->cause == CAUSE_MELEE) ? "Officer overpowered" : "Officer down", game->time);
+            break;
+        case EVENT_PROTESTER_DOWN:
+            PushFeedMessage(&game->stats, (ev->cause == CAUSE_HELICOPTER) ? "Helicopter fire!" : "Protester shot", game->time);
+            break;
+        case EVENT_CHANT_HEARD: {
+            Protester *pr = &game->protesters[ev->target];
+            if (!pr->alive) break;
+            pr->morale = Clamp(pr->morale + ev->amount, 0.0f, 100.0f);
+            break;
+        }
+        case EVENT_CHANT:
+            game->globalMorale += ev->amount;
+            break;
+        }
+    }
+
+    game->globalMorale = Clamp(game->globalMorale, 0, 100);
+    if (game->globalMorale > game->max_morale_reached) {
+        game->max_morale_reached = game->globalMorale;
+    }
+}
+
+// Arms the arrival timer for the next spawn time, or for the next tick if
+// that time already passed while the previous helicopter was still flying
+void ScheduleNextHelicopter(GameState *game) {
+    if (game->helicopter.current_spawn >= 3) return;
+    double due = game->gameStartTime + game->helicopter.spawn_times[game->helicopter.current_spawn];
+    ScheduleTimer(game, TIMER_HELICOPTER, 0, (float)(due - game->time));
+}
+
+void SpawnHelicopter(GameState *game) {
+    if (game->helicopter.active || game->time - game->gameStartTime >= 300.0f) return;
+    game->helicopter.active = 1;
+    game->helicopter.pos = (Vector2){game->worldWidth + 32, 50.0f};
+    game->helicopter.vel = (Vector2){-4.0f, 0.0f};
+    game->helicopter.appear_timer = GameRandom(game, 10, 20);
+    game->helicopter.shots_fired = 0;
+    game->helicopter.shot_cooldown = 0.0f;
+    game->helicopter.current_spawn++;
+    PlayGameSound(game, SFX_HELICOPTER, game->helicopter.pos);
+}
+
+void InitHelicopter(GameState *game) {
+    game->helicopter.active = 0;
+    game->helicopter.current_spawn = 0;
+    for (int i = 0; i < 3; i++) {
+        game->helicopter.spawn_times[i] = GameRandom(game, 0, 300);
+    }
+    for (int i = 0; i < 2; i++) {
+        for (int j = i+1; j < 3; j++) {
+            if (game->helicopter.spawn_times[i] > game->helicopter.spawn_times[j]) {
+                float temp = game->helicopter.spawn_times[i];
+                game->helicopter.spawn_times[i] = game->helicopter.spawn_times[j];
+                game->helicopter.spawn_times[j] = temp;
+            }
+        }
+    }
+    for (int i = 1; i < 3; i++) {
+        if (game->helicopter.spawn_times[i] - game->helicopter.spawn_times[i-1] < 30.0f) {
+            game->helicopter.spawn_times[i] += 30.0f;
+            if (game->helicopter.spawn_times[i] > 300.0f) game->helicopter.spawn_times[i] = 300.0f;
+        }
+    }
+    ScheduleNextHelicopter(game);
+}
+
+void UpdateHelicopter(GameState *game, float dt) {
+    double timer = game->time - game->gameStartTime;
+    if (timer >= 300.0f) return;
+    if (game->helicopter.active) {
+        game->helicopter.pos.x += game->helicopter.vel.x;
+        game->helicopter.pos.y += sinf(timer * 2.0f) * 0.5f;
+        game->helicopter.appear_timer -= dt;
+        game->helicopter.shot_cooldown -= dt;
+        EmitParticles(game, PARTICLES_WASH, Vector2Add(game->helicopter.pos, (Vector2){0, 24}), (Vector2){0, 1});
+        int shot_limit = 4;
+        if (game->helicopter.pos.x < -32 || game->helicopter.shots_fired >= shot_limit) {
+            game->helicopter.active = 0;
+            ScheduleNextHelicopter(game);
+            return;
+        }
+        if (game->helicopter.shot_cooldown <= 0) {
+            int target_idx = -1;
+            for (int tries = 0; tries < 10; tries++) {
+                int j = GameRandom(game, 0, game->maxProtesters - 1);
+                if (PackedAlive(game->crowd[j]) && PackedState(game->crowd[j]) == RIOT) {
+                    target_idx = j;
+                    break;
                 }
-                break;
-            case RIOT:
-                speedMultiplier = 2.0f;
-                float closestDist = 9999.0f;
-                Vector2 closestTarget = p->pos;
-                for (int j = 0; j < MAX_POLICE; j++) {
-                    if (game->police[j].alive) {
-                        float dist = Vector2Distance(p->pos, game->police[j].pos);
-                        if (dist < closestDist) {
-                            closestDist = dist;
-                            closestTarget = game->police[j].pos;
-                        }
+            }
+            if (target_idx == -1) {
+                for (int j = 0; j < game->maxProtesters; j++) {
+                    if (PackedAlive(game->crowd[j])) {
+                        target_idx = j;
+                        break;
                     }
                 }
-                if (closestDist < 9999.0f) {
-                    stateForce = Vector2Scale(Vector2Normalize(Vector2Subtract(closestTarget, p->pos)), 1.5f);
-                }
-                break;
-            case FLEE:
-                speedMultiplier = 3.0f;
-                for (int j = 0; j < MAX_POLICE; j++) {
-                    if (game->police[j].alive) {
-                        float dist = Vector2Distance(p->pos, game->police[j].pos);
-                        if (dist < 100.0f) {
-                            Vector2 away = Vector2Scale(Vector2Normalize(Vector2Subtract(p->pos, game->police[j].pos)), 2.0f);
-                            stateForce = Vector2Add(stateForce, away);
-                        }
+            }
+            if (target_idx != -1) {
+                Vector2 target = PackedPosition(game->crowd[target_idx], game->worldWidth);
+                for (int i = 0; i < game->maxProjectiles; i++) {
+                    if (!game->projectiles[i].active) {
+                        game->projectiles[i].pos = game->helicopter.pos;
+                        Vector2 dir = Vector2Normalize(Vector2Subtract(target, game->helicopter.pos));
+                        game->projectiles[i].vel = Vector2Scale(dir, 400.0f);
+                        game->projectiles[i].owner_id = -1;
+                        game->projectiles[i].lifetime = 0.0f;
+                        game->projectiles[i].active = 1;
+                        game->projectiles[i].type = HELICOPTER_BULLET;
+                        game->projectiles[i].damage = 100.0f;
+                        game->projectiles[i].distance = 0.0f;
+                        game->projectiles[i].max_distance = game->worldWidth;
+                        game->helicopter.shots_fired++;
+                        game->helicopter.shot_cooldown = GameRandom(game, 2, 4);
+                        break;
                     }
                 }
-                p->behavior_timer += GetFrameTime();
-                if (p->behavior_timer > 5.0f) {
-                    p->state = IDLE;
-                    p->behavior_timer = 0.0f;
-                }
-                break;
-            case IDLE:
-            default:
-                speedMultiplier = 1.0f;
-                break;
+            }
         }
-        EnforceProtesterBoundaries(p, game, i);
-        Vector2 totalForce = Vector2Add(targetForce, stateForce);
-        float maxSpeed = 2.5f * speedMultiplier;
-        if (Vector2Length(totalForce) > maxSpeed) {
-            totalForce = Vector2Scale(Vector2Normalize(totalForce), maxSpeed);
+    }
+}
+
+void DrawHelicopter(GameState *game, Texture2D helicopterSprite) {
+    if (game->helicopter.active) {
+        if (helicopterSprite.id != 0) {
+            DrawTexture(helicopterSprite, (int)(game->helicopter.pos.x - 16), (int)(game->helicopter.pos.y - 8), WHITE);
+        } else {
+            DrawRectangle((int)(game->helicopter.pos.x - 16), (int)(game->helicopter.pos.y - 8), 32, 16, GRAY);
         }
-        p->vel = Vector2Lerp(p->vel, totalForce, 0.3f);
-        p->pos = Vector2Add(p->pos, p->vel);
-        p->pos.x = Clamp(p->pos.x, 16, 1584);
-        p->pos.y = Clamp(p->pos.y, 318, 724);
-        if (p->state == CHANT) p->morale += 0.2f;
-        if (p->state == FLEE) p->morale -= 0.5f;
-        p->morale = Clamp(p->morale, 0.0f, 100.0f);
+    }
+}
 
-        if (p->state == RIOT) {
-            for (int k = 0; k < MAX_POLICE; k++) {
-                if (game->police[k].alive && Vector2Distance(p->pos, game->police[k].pos) < 20.0f) {
-                    game->police[k].health -= 10.0f * GetFrameTime();
-                    if (game->police[k].health <= 0.0f) {
-                        game->police[k].alive = false;
-                        game->globalMorale += 3.0f;
-                    }
-                }
-            }
+// Lanes are Catmull-Rom splines through control points VEHICLE_LANE_SPACING
+// apart in x. With evenly spaced points the spline's x is linear in the
+// segment parameter, so a lane is a function y(x) and vehicles are placed
+// by x alone.
+typedef struct
+{
+    float length; // footprint along the lane
+    float depth;  // footprint across it
+    float speed;  // cruising
+} VehicleInfo;
+
+static const VehicleInfo VEHICLE_INFO[VEHICLE_KIND_COUNT] = {
+    [VEHICLE_BUS] = {150.0f, 40.0f, 70.0f},
+    [VEHICLE_CAR] = {90.0f, 30.0f, 110.0f},
+    [VEHICLE_VAN] = {100.0f, 34.0f, 130.0f},
+};
+
+// Outer lanes stay far enough from the field's edges for people to get
+// past a vehicle on either side
+static const float LANE_BASE_Y[VEHICLE_LANE_COUNT] = {FIELD_TOP + 70.0f, (FIELD_TOP + FIELD_BOTTOM) * 0.5f, FIELD_BOTTOM - 70.0f};
+static const float LANE_DIR[VEHICLE_LANE_COUNT] = {-1.0f, 1.0f, -1.0f}; // police vans come in on the leftward lanes
+
+int LanePointCount(float worldWidth)
+{
+    return (int)ceilf(worldWidth / VEHICLE_LANE_SPACING) + 1;
+}
+
+// Lane y at x and its slope dy/dx
+static float LaneY(const GameState *game, int lane, float x, float *slope)
+{
+    const float *y = game->laneY + lane * game->lanePoints;
+    int last = game->lanePoints - 1;
+    float u = Clamp(x / VEHICLE_LANE_SPACING, 0.0f, (float)last);
+    int i = (int)u;
+    if (i >= last) i = last - 1;
+    float t = u - i;
+    float p0 = y[(i > 0) ? i - 1 : 0];
+    float p1 = y[i];
+    float p2 = y[i + 1];
+    float p3 = y[(i + 2 <= last) ? i + 2 : last];
+    float a = 2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3;
+    float b = -p0 + 3.0f * p1 - 3.0f * p2 + p3;
+    if (slope != NULL) *slope = 0.5f * ((p2 - p0) + 2.0f * a * t + 3.0f * b * t * t) / VEHICLE_LANE_SPACING;
+    return 0.5f * (2.0f * p1 + (p2 - p0) * t + a * t * t + b * t * t * t);
+}
+
+static void PlaceVehicle(const GameState *game, Vehicle *v, float x)
+{
+    float slope;
+    v->pos = (Vector2){x, LaneY(game, v->lane, x, &slope)};
+    v->heading = Vector2Normalize((Vector2){v->dir, v->dir * slope});
+}
+
+// Brings a vehicle in at the lane's upstream edge; false if the pool is
+// full or traffic is backed up to the edge
+static bool SpawnVehicle(GameState *game, VehicleKind kind, int lane, float stopX)
+{
+    float entry = (LANE_DIR[lane] > 0.0f) ? 0.0f : game->worldWidth;
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+        const Vehicle *v = &game->vehicles[i];
+        if (v->active && v->lane == lane && fabsf(v->pos.x - entry) < VEHICLE_INFO[v->kind].length + VEHICLE_GAP) return false;
+    }
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+        Vehicle *v = &game->vehicles[i];
+        if (v->active) continue;
+        float half = VEHICLE_INFO[kind].length * 0.5f;
+        *v = (Vehicle){.kind = kind, .active = true, .lane = lane, .dir = LANE_DIR[lane], .stopX = stopX};
+        v->speed = VEHICLE_INFO[kind].speed;
+        PlaceVehicle(game, v, (v->dir > 0.0f) ? -half : game->worldWidth + half);
+        v->prevPos = v->pos;
+        return true;
+    }
+    return false;
+}
+
+// New lane shapes for the match and an empty street
+void ResetVehicles(GameState *game)
+{
+    for (int lane = 0; lane < VEHICLE_LANE_COUNT; lane++) {
+        float *y = game->laneY + lane * game->lanePoints;
+        for (int k = 0; k < game->lanePoints; k++) y[k] = LANE_BASE_Y[lane] + GameRandom(game, -30, 30);
+        ScheduleTimer(game, TIMER_TRAFFIC, lane, (float)GameRandom(game, 1, (int)VEHICLE_SPAWN_INTERVAL));
+    }
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) game->vehicles[i].active = false;
+}
+
+// Surge start sends vans to park across the police half of the street;
+// surge end sends them on down the lane
+void DeployPoliceVans(GameState *game, bool deploy)
+{
+    if (!deploy) {
+        for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+            Vehicle *v = &game->vehicles[i];
+            if (!v->active || v->kind != VEHICLE_VAN) continue;
+            v->parked = false;
+            v->stopX = -1.0f;
+        }
+        return;
+    }
+    int vans = 0;
+    for (int lane = 0; lane < VEHICLE_LANE_COUNT && vans < VEHICLE_VANS; lane++) {
+        if (LANE_DIR[lane] > 0.0f) continue;
+        for (int n = 0; n < 2 && vans < VEHICLE_VANS; n++) {
+            float stopX = game->worldWidth * 0.6f + n * (VEHICLE_INFO[VEHICLE_VAN].length + VEHICLE_GAP) + GameRandom(game, 0, 40);
+            if (SpawnVehicle(game, VEHICLE_VAN, lane, stopX)) vans++;
         }
     }
+}
 
-    if (chantingCount > 0) {
-        game->globalMorale += (float)chantingCount * 0.1f;
+// Box swept by a vehicle this tick: its footprint stretched back over the
+// distance it travelled along its heading
+typedef struct
+{
+    Vector2 center;
+    Vector2 axis; // heading
+    float halfLength;
+    float halfDepth;
+} SweptBox;
+
+static SweptBox VehicleSweep(const Vehicle *v)
+{
+    float travel = fmaxf(Vector2DotProduct(Vector2Subtract(v->pos, v->prevPos), v->heading), 0.0f);
+    return (SweptBox){Vector2Subtract(v->pos, Vector2Scale(v->heading, travel * 0.5f)), v->heading,
+                      VEHICLE_INFO[v->kind].length * 0.5f + travel * 0.5f, VEHICLE_INFO[v->kind].depth * 0.5f};
+}
+
+static Rectangle SweptBounds(const SweptBox *box, float margin)
+{
+    float ex = fabsf(box->axis.x) * box->halfLength + fabsf(box->axis.y) * box->halfDepth + margin;
+    float ey = fabsf(box->axis.y) * box->halfLength + fabsf(box->axis.x) * box->halfDepth + margin;
+    return (Rectangle){box->center.x - ex, box->center.y - ey, 2.0f * ex, 2.0f * ey};
+}
+
+// Moves a disc out of the box. Discs beside the vehicle go out sideways;
+// those caught by its front are shoved ahead and to the nearer side, so a
+// moving vehicle parts a crowd instead of carrying it along. `sideways`
+// forces the former, for discs with nowhere to go ahead.
+static bool PushOutOfSweep(const SweptBox *box, Vector2 *pos, float radius, bool sideways)
+{
+    Vector2 normal = {-box->axis.y, box->axis.x};
+    Vector2 d = Vector2Subtract(*pos, box->center);
+    float along = Vector2DotProduct(d, box->axis);
+    float across = Vector2DotProduct(d, normal);
+    float overlapAlong = box->halfLength + radius - fabsf(along);
+    float overlapAcross = box->halfDepth + radius - fabsf(across);
+    if (overlapAlong <= 0.0f || overlapAcross <= 0.0f) return false;
+    float side = (across >= 0.0f) ? 1.0f : -1.0f;
+    if (sideways || overlapAcross <= overlapAlong) {
+        *pos = Vector2Add(*pos, Vector2Scale(normal, side * overlapAcross));
+    } else {
+        float ahead = (along >= 0.0f) ? 1.0f : -1.0f;
+        *pos = Vector2Add(*pos, Vector2Add(Vector2Scale(box->axis, ahead * overlapAlong),
+                                           Vector2Scale(normal, side * 0.5f * overlapAlong)));
     }
+    return true;
+}
 
-    double now = GetTime();
-    if (now - game->lastMoraleTime > 1.0) {
-        game->globalMorale -= 0.2f;
-        game->lastMoraleTime = now;
+// Slab test of the segment from `from` to `to` against a vehicle's footprint
+static bool SegmentHitsVehicle(const Vehicle *v, Vector2 from, Vector2 to)
+{
+    Vector2 normal = {-v->heading.y, v->heading.x};
+    Vector2 d0 = Vector2Subtract(from, v->pos);
+    Vector2 delta = Vector2Subtract(to, from);
+    float origin[2] = {Vector2DotProduct(d0, v->heading), Vector2DotProduct(d0, normal)};
+    float step[2] = {Vector2DotProduct(delta, v->heading), Vector2DotProduct(delta, normal)};
+    float half[2] = {VEHICLE_INFO[v->kind].length * 0.5f, VEHICLE_INFO[v->kind].depth * 0.5f};
+    float enter = 0.0f, leave = 1.0f;
+    for (int axis = 0; axis < 2; axis++) {
+        if (fabsf(step[axis]) < 1e-6f) {
+            if (fabsf(origin[axis]) > half[axis]) return false;
+            continue;
+        }
+        float t0 = (-half[axis] - origin[axis]) / step[axis];
+        float t1 = (half[axis] - origin[axis]) / step[axis];
+        if (t0 > t1) {
+            float swap = t0;
+            t0 = t1;
+            t1 = swap;
+        }
+        enter = fmaxf(enter, t0);
+        leave = fminf(leave, t1);
+        if (enter > leave) return false;
     }
+    return true;
+}
 
-    game->globalMorale = Clamp(game->globalMorale, 0, 100);
-    game->protesterCount = activeProtesters;
+// True if a ground projectile moving from `from` to `to` ran into a vehicle
+bool ProjectileBlocked(const GameState *game, Vector2 from, Vector2 to)
+{
+    Rectangle path = {fminf(from.x, to.x), fminf(from.y, to.y), fabsf(to.x - from.x), fabsf(to.y - from.y)};
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+        const Vehicle *v = &game->vehicles[i];
+        if (!v->active) continue;
+        SweptBox box = {v->pos, v->heading, VEHICLE_INFO[v->kind].length * 0.5f, VEHICLE_INFO[v->kind].depth * 0.5f};
+        if (CheckCollisionRecs(path, SweptBounds(&box, 1.0f)) && SegmentHitsVehicle(v, from, to)) return true;
+    }
+    return false;
+}
 
-    if (game->globalMorale > game->max_morale_reached) {
-        game->max_morale_reached = game->globalMorale;
+// Parks or releases the civilian vehicle under `point`
+void ToggleBarricade(GameState *game, Vector2 point)
+{
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+        Vehicle *v = &game->vehicles[i];
+        if (!v->active || v->kind == VEHICLE_VAN || !SegmentHitsVehicle(v, point, point)) continue;
+        v->parked = !v->parked;
+        v->speed = 0.0f;
+        PushFeedMessage(&game->stats, v->parked ? "Protesters block the road" : "Barricade cleared", game->time);
+        return;
     }
 }
 
-void UpdatePolice(GameState *game)
+// Advances traffic along the lanes. A vehicle keeps VEHICLE_GAP behind the
+// next one in its lane and slows while it is pushing through people.
+// Officers are pushed here; protesters by the crowd solver, which runs next
+// and owns their positions.
+void UpdateVehicles(GameState *game)
 {
-    int activePolice = 0;
-    for (int i = 0; i < MAX_POLICE; i++) {
-        Police *p = &game->police[i];
-        if (!p->alive) continue;
-        activePolice++;
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+        Vehicle *v = &game->vehicles[i];
+        if (!v->active) continue;
+        v->prevPos = v->pos;
+        if (v->parked) continue;
 
-        float cycle_time = (p->state == INTERVENE || p->state == DEPLOY) ? 0.2f : 0.4f;
-        p->anim_timer += GetFrameTime();
-        int frame_count = (p->state == INTERVENE || p->state == DEPLOY) ? 3 : 2;
-        if (p->anim_timer >= cycle_time) {
-            p->anim_frame = (p->anim_frame + 1) % frame_count;
-            p->anim_timer = 0.0f;
+        const VehicleInfo *info = &VEHICLE_INFO[v->kind];
+        float target = info->speed / (1.0f + 0.25f * v->contacts);
+        for (int j = 0; j < VEHICLE_CAPACITY; j++) {
+            const Vehicle *other = &game->vehicles[j];
+            if (j == i || !other->active || other->lane != v->lane) continue;
+            float ahead = (other->pos.x - v->pos.x) * v->dir;
+            float clearance = ahead - 0.5f * (info->length + VEHICLE_INFO[other->kind].length);
+            if (ahead > 0.0f && clearance < VEHICLE_GAP) target = 0.0f;
         }
-        p->face_right = (p->vel.x >= 0);
+        v->speed += Clamp(target - v->speed, -VEHICLE_BRAKING * game->dt, VEHICLE_BRAKING * game->dt);
 
-        p->timer -= GetFrameTime();
+        float slope;
+        LaneY(game, v->lane, v->pos.x, &slope);
+        float x = v->pos.x + v->dir * v->speed * game->dt / sqrtf(1.0f + slope * slope);
+        if (v->stopX >= 0.0f && (x - v->stopX) * v->dir >= 0.0f) {
+            x = v->stopX;
+            v->parked = true;
+            v->speed = 0.0f;
+        }
+        float half = info->length * 0.5f;
+        if (x < -half - 1.0f || x > game->worldWidth + half + 1.0f) {
+            v->active = false;
+            continue;
+        }
+        PlaceVehicle(game, v, x);
+    }
 
-        float closestDist = 120.0f;
-        int targetIdx = -1;
-        for (int j = 0; j < MAX_PROTESTERS; j++) {
-            if (!game->protesters[j].alive) continue;
-            float dist = Vector2Distance(p->pos, game->protesters[j].pos);
-            if (dist < closestDist) {
-                closestDist = dist;
-                targetIdx = j;
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+        Vehicle *v = &game->vehicles[i];
+        if (!v->active) continue;
+        v->contacts = 0;
+        SweptBox box = VehicleSweep(v);
+        Rectangle bounds = SweptBounds(&box, CROWD_POLICE_RADIUS);
+        for (int j = 0; j < game->maxPolice; j++) {
+            Police *p = &game->police[j];
+            if (p->alive && CheckCollisionPointRec(p->pos, bounds) && PushOutOfSweep(&box, &p->pos, CROWD_POLICE_RADIUS, false)) {
+                p->pos.y = Clamp(p->pos.y, FIELD_TOP, FIELD_BOTTOM);
+                v->contacts++;
             }
         }
-        if (targetIdx != -1 && police_cooldown[p->id] <= 0.0f) {
-            ShootBullet(game, p, game->protesters[targetIdx].pos);
+    }
+}
+
+// Vehicles are drawn under the agents, so the atlas batch that follows
+// stays whole; agents are never inside one for long anyway
+void DrawVehicles(const GameState *game, Texture2D bus, Texture2D car, Rectangle cull)
+{
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+        const Vehicle *v = &game->vehicles[i];
+        if (!v->active) continue;
+        const VehicleInfo *info = &VEHICLE_INFO[v->kind];
+        Texture2D sprite = (v->kind == VEHICLE_BUS) ? bus : car;
+        float height = (sprite.id != 0) ? info->length * sprite.height / sprite.width : info->depth * 2.0f;
+        // The wheels sit on the near edge of the footprint
+        Rectangle dest = {v->pos.x - info->length * 0.5f, v->pos.y + info->depth * 0.5f - height, info->length, height};
+        if (!CheckCollisionRecs(dest, cull)) continue;
+        Color tint = (v->kind == VEHICLE_VAN) ? (Color){90, 100, 170, 255} : WHITE;
+        if (sprite.id != 0) {
+            Rectangle src = {0, 0, (float)sprite.width * (v->dir < 0.0f ? -1.0f : 1.0f), (float)sprite.height};
+            DrawTexturePro(sprite, src, dest, (Vector2){0, 0}, 0.0f, tint);
+        } else {
+            DrawRectangleRec(dest, (v->kind == VEHICLE_VAN) ? DARKBLUE : (v->kind == VEHICLE_BUS) ? ORANGE : MAROON);
+        }
+        if (v->parked) {
+            DrawRectangleLinesEx(dest, 2.0f, (v->kind == VEHICLE_VAN) ? BLUE : RED);
         }
+    }
+}
 
-        switch (p->state) {
-        case PATROL: {
-            Vector2 patrolTarget = {GetRandomValue(800, 1500), p->pos.y + GetRandomValue(-50, 50)};
-            Vector2 toTarget = Vector2Subtract(patrolTarget, p->pos);
-            if (Vector2Length(toTarget) > 5.0f) {
-                p->vel = Vector2Scale(Vector2Normalize(toTarget), 1.0f);
-            } else {
-                p->vel = Vector2Scale(p->vel, 0.9f);
-            }
+bool InitGame(GameState *game, ScenarioConfig scenario);
+void ResetGame(GameState *game);
+int CrowdGridCells(float worldWidth);
+void ShutdownGame(GameState *game);
+void UpdateGame(GameState *game, float dt);
+void UpdateProtesters(GameState *game);
+void ShootBullet(GameState *game, Police* p, Vector2 target);
+void UpdatePolice(GameState *game);
+void UpdateTearGas(GameState *game);
+void HandleInput(GameState *game);
+void DrawGame(GameState *game, const GameAssets *assets, LayerCache *layers, Font pixelFont, Texture2D *textures);
+void DrawUI(GameState *game, LayerCache *layers, Font pixelFont);
+bool CheckWinCondition(GameState *game);
+bool CheckLoseCondition(GameState *game);
+
+// Carves the entity pools for the scenario out of one persistent arena.
+// Called once; restarts go through ResetGame and reuse the same memory.
+bool InitGame(GameState *game, ScenarioConfig scenario)
+{
+    memset(game, 0, sizeof(GameState));
+
+    game->scenario = scenario;
+    game->maxProtesters = scenario.maxProtesters;
+    game->maxPolice = scenario.maxPolice;
+    game->maxProjectiles = scenario.maxProjectiles;
+    game->maxGas = scenario.maxGas;
+    game->worldWidth = (float)scenario.worldWidth;
+    game->squadCount = (game->maxPolice + SQUAD_SIZE - 1) / SQUAD_SIZE;
+    game->lanePoints = LanePointCount(game->worldWidth);
+
+    size_t poolSize = sizeof(Protester) * game->maxProtesters +
+                      sizeof(PackedProtester) * game->maxProtesters +
+                      sizeof(uint64_t) * SelectionWords(game) +
+                      sizeof(Police) * game->maxPolice +
+                      sizeof(Squad) * game->squadCount +
+                      sizeof(Vehicle) * VEHICLE_CAPACITY +
+                      sizeof(float) * VEHICLE_LANE_COUNT * game->lanePoints +
+                      sizeof(TimerNode) * (2 * game->maxProtesters + game->maxPolice + game->squadCount + scenario.waveCount +
+                                           VEHICLE_LANE_COUNT + TIMER_KIND_COUNT + TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS) +
+                      sizeof(TearGas) * game->maxGas +
+                      sizeof(Projectile) * game->maxProjectiles +
+                      10 * ARENA_ALIGNMENT;
+    // Per frame: the event queue, chant morale, the draw list, one batched order's
+    // scratch (free projectile slots plus the police grid) and the crowd
+    // solver's agent arrays and grids
+    size_t gridCells = (size_t)(ceilf(game->worldWidth / POLICE_GRID_CELL) * ceilf(WORLD_HEIGHT / POLICE_GRID_CELL));
+    size_t crowdCells = (size_t)CrowdGridCells(game->worldWidth);
+    size_t frameSize = sizeof(GameEvent) * EventQueueCapacity(game) +
+                       sizeof(float) * game->maxProtesters + // chant morale heard per protester
+                       sizeof(DrawEntity) * (game->maxProtesters + game->maxPolice) +
+                       sizeof(int) * (game->maxProjectiles + 2 * game->maxPolice + 2 * gridCells + 1) +
+                       sizeof(int) * (2 * game->maxPolice + 2 * gridCells + 1) + // the crowd solver's police grid
+                       (sizeof(int) * 2 + sizeof(bool) + sizeof(Vector2) * 2) * game->maxProtesters +
+                       sizeof(int) * (2 * crowdCells + 1) +
+                       16 * ARENA_ALIGNMENT;
+    if (frameSize < FRAME_ARENA_MIN_SIZE) frameSize = FRAME_ARENA_MIN_SIZE;
+
+    if (!ArenaInit(&game->poolArena, poolSize) || !ArenaInit(&game->frameArena, frameSize)) {
+        TraceLog(LOG_ERROR, "GAME: Failed to allocate entity pools");
+        ShutdownGame(game);
+        return false;
+    }
+
+    game->protesters = ArenaAllocZeroed(&game->poolArena, sizeof(Protester) * game->maxProtesters);
+    game->crowd = ArenaAllocZeroed(&game->poolArena, sizeof(PackedProtester) * game->maxProtesters);
+    game->selected = ArenaAllocZeroed(&game->poolArena, sizeof(uint64_t) * SelectionWords(game));
+    game->police = ArenaAllocZeroed(&game->poolArena, sizeof(Police) * game->maxPolice);
+    game->squads = ArenaAllocZeroed(&game->poolArena, sizeof(Squad) * game->squadCount);
+    game->gas = ArenaAllocZeroed(&game->poolArena, sizeof(TearGas) * game->maxGas);
+    game->projectiles = ArenaAllocZeroed(&game->poolArena, sizeof(Projectile) * game->maxProjectiles);
+    game->vehicles = ArenaAllocZeroed(&game->poolArena, sizeof(Vehicle) * VEHICLE_CAPACITY);
+    game->laneY = ArenaAllocZeroed(&game->poolArena, sizeof(float) * VEHICLE_LANE_COUNT * game->lanePoints);
+    int timerCounts[TIMER_KIND_COUNT] = {
+        [TIMER_STONE_COOLDOWN] = game->maxProtesters,
+        [TIMER_FLEE_END] = game->maxProtesters,
+        [TIMER_POLICE_COOLDOWN] = game->maxPolice,
+        [TIMER_SURGE] = 1,
+        [TIMER_HELICOPTER] = 1,
+        [TIMER_MORALE_DECAY] = 1,
+        [TIMER_CONTROL_HOLD] = 1,
+        [TIMER_SQUAD_PLAN] = game->squadCount,
+        [TIMER_WAVE] = scenario.waveCount,
+        [TIMER_TRAFFIC] = VEHICLE_LANE_COUNT
+    };
+    InitTimerWheel(&game->timers, &game->poolArena, timerCounts);
+
+    SeedGameRandom(game, scenario.seed);
+    ResetGame(game);
+    return true;
+}
+
+void ShutdownGame(GameState *game)
+{
+    ArenaFree(&game->poolArena);
+    ArenaFree(&game->frameArena);
+}
+
+static float WaveBandX(const GameState *game, float x)
+{
+    return (x < 0.0f) ? game->worldWidth + x : x;
+}
+
+// Brings a protester into slot i, which may have been vacated by an arrest
+// or a rout earlier in the match
+static void SpawnProtester(GameState *game, int i, const SpawnWave *wave)
+{
+    Protester *p = &game->protesters[i];
+    p->pos = (Vector2){GameRandom(game, (int)WaveBandX(game, wave->minX), (int)WaveBandX(game, wave->maxX)), GameRandom(game, 302, 740)};
+    p->vel = (Vector2){0, 0};
+    p->state = (i % 3 == 0) ? CHANT : IDLE;
+    p->morale = GameRandom(game, 80, 100);
+    p->is_agitator = (i < 10);
+    p->alive = true;
+    p->group_id = i / 10;
+    p->target_pos = p->pos;
+    p->anim_phase = (unsigned char)GameRandom(game, 0, 127);
+    p->face_right = true;
+    game->selected[i >> 6] &= ~(1ull << (i & 63));
+    CancelTimer(game, TIMER_STONE_COOLDOWN, i);
+    CancelTimer(game, TIMER_FLEE_END, i);
+    game->protesterCount++;
+    game->protesterArrivals++;
+}
+
+// Officers join the squad that owns their slot
+static void SpawnPolice(GameState *game, int i, const SpawnWave *wave)
+{
+    Police *p = &game->police[i];
+    p->pos = (Vector2){GameRandom(game, (int)WaveBandX(game, wave->minX), (int)WaveBandX(game, wave->maxX)), GameRandom(game, 302, 740)};
+    p->vel = (Vector2){0, 0};
+    p->state = game->squads[i / SQUAD_SIZE].order;
+    p->health = 100.0f;
+    p->alive = true;
+    p->id = i;
+    p->anim_phase = (unsigned char)GameRandom(game, 0, 127);
+    p->face_right = true;
+    CancelTimer(game, TIMER_POLICE_COOLDOWN, i);
+    game->policeCount++;
+}
+
+// Next free slot of a faction's pool, searching on from where the last one
+// was found; -1 once a full lap finds none
+static int FindFreeSlot(GameState *game, int faction)
+{
+    int capacity = (faction == FACTION_POLICE) ? game->maxPolice : game->maxProtesters;
+    int *cursor = &game->spawnCursor[faction];
+    for (int n = 0; n < capacity; n++) {
+        int i = *cursor;
+        *cursor = (i + 1 < capacity) ? i + 1 : 0;
+        bool alive = (faction == FACTION_POLICE) ? game->police[i].alive : game->protesters[i].alive;
+        if (!alive) return i;
+    }
+    return -1;
+}
+
+// Places up to `budget` waiting arrivals, oldest wave first. Arrivals that
+// find their pool full keep waiting for slots to free up.
+void SpawnWaves(GameState *game, int budget)
+{
+    bool full[2] = {false, false};
+    for (int w = 0; w < game->scenario.waveCount && budget > 0; w++) {
+        const SpawnWave *wave = &game->scenario.waves[w];
+        while (game->waveRemaining[w] > 0 && budget > 0 && !full[wave->faction]) {
+            int slot = FindFreeSlot(game, wave->faction);
+            if (slot < 0) {
+                full[wave->faction] = true;
+                break;
+            }
+            if (wave->faction == FACTION_POLICE) SpawnPolice(game, slot, wave);
+            else SpawnProtester(game, slot, wave);
+            game->waveRemaining[w]--;
+            budget--;
+        }
+    }
+}
+
+bool ReinforcementsDue(const GameState *game)
+{
+    for (int w = 0; w < game->scenario.waveCount; w++) {
+        if (game->scenario.waves[w].faction != FACTION_POLICE) continue;
+        if (game->waveRemaining[w] > 0 || TimerPending(game, TIMER_WAVE, w)) return true;
+    }
+    return false;
+}
+
+// Puts a match back to its starting state without touching the pools'
+// allocation or any GPU resources.
+void ResetGame(GameState *game)
+{
+    game->isSelecting = false;
+    game->globalMorale = 50.0f;
+    game->gameStartTime = game->time;
+    ResetTimerWheel(&game->timers, (uint32_t)(game->time * TIMER_TICK_RATE));
+    ScheduleTimer(game, TIMER_SURGE, 0, SURGE_INTERVAL);
+    ScheduleTimer(game, TIMER_MORALE_DECAY, 0, 1.0f);
+    game->policeSurgeActive = false;
+    game->policeSurgeEnd = 0;
+    game->menuState = MENU_START;
+    game->protesterCount = 0;
+    game->policeCount = 0;
+    game->protesterArrivals = 0;
+    game->controlProgress = 0.0f;
+    game->controlStartTime = 0;
+    game->protesters_arrested = 0;
+    game->max_morale_reached = 0.0f;
+    game->animTime = 0.0f;
+    game->camera = (Camera2D){0};
+    game->camera.zoom = 1.0f;
+    memset(&game->stats, 0, sizeof(game->stats));
+
+    // Every slot starts empty; the scenario's starting forces fill them now
+    // and later waves are streamed in by SpawnWaves
+    for (int i = 0; i < game->maxProtesters; i++) {
+        game->protesters[i] = (Protester){.state = IDLE, .alive = false};
+    }
+    memset(game->selected, 0, sizeof(uint64_t) * SelectionWords(game));
+    for (int i = 0; i < game->maxPolice; i++) {
+        game->police[i] = (Police){.state = PATROL, .alive = false, .id = i};
+    }
+    game->spawnCursor[FACTION_PROTESTER] = 0;
+    game->spawnCursor[FACTION_POLICE] = 0;
+    const ScenarioConfig *scenario = &game->scenario;
+    for (int w = 0; w < scenario->waveCount; w++) {
+        bool starting = scenario->waves[w].time <= 0.0f;
+        game->waveRemaining[w] = starting ? scenario->waves[w].count : 0;
+        if (!starting) ScheduleTimer(game, TIMER_WAVE, w, scenario->waves[w].time);
+    }
+    SpawnWaves(game, game->maxProtesters + game->maxPolice);
+    PackCrowd(game);
+
+    for (int g = 0; g < game->maxGas; g++) {
+        game->gas[g].active = false;
+    }
+
+    // Gas slots are split evenly, so squads never contend for a canister.
+    // Planning passes are staggered across one interval.
+    for (int s = 0; s < game->squadCount; s++) {
+        Squad *squad = &game->squads[s];
+        squad->order = PATROL;
+        squad->anchor = (Vector2){game->worldWidth - 250.0f, (FIELD_TOP + FIELD_BOTTOM) * 0.5f};
+        for (int i = s * SQUAD_SIZE; i < game->maxPolice && i < (s + 1) * SQUAD_SIZE; i++) {
+            if (!game->police[i].alive) continue;
+            squad->anchor = game->police[i].pos;
+            break;
+        }
+        squad->facing = (Vector2){-1.0f, 0.0f};
+        squad->waypoint = squad->anchor;
+        squad->targetIndex = -1;
+        squad->firstGas = s * game->maxGas / game->squadCount;
+        squad->gasCount = (s + 1) * game->maxGas / game->squadCount - squad->firstGas;
+        squad->deployEnd = 0.0;
+        ScheduleTimer(game, TIMER_SQUAD_PLAN, s, SQUAD_PLAN_INTERVAL * (s + 1) / game->squadCount);
+    }
+
+    for (int i = 0; i < game->maxProjectiles; i++) {
+        game->projectiles[i].active = false;
+        game->projectiles[i].lifetime = 0.0f;
+        game->projectiles[i].owner_id = -1;
+        game->projectiles[i].pos = (Vector2){0,0};
+        game->projectiles[i].vel = (Vector2){0,0};
+        game->projectiles[i].distance = 0.0f;
+        game->projectiles[i].max_distance = 320.0f;
+    }
+
+    InitHelicopter(game);
+    ResetVehicles(game);
+}
+
+// Chanting lifts the morale of everyone within earshot. Neighbours come
+// from the packed snapshot and the lift is summed here, then applied by
+// the reducer, so it does not depend on update order.
+void UpdateProtesters(GameState *game)
+{
+    int chantingCount = 0;
+    int activeProtesters = 0;
+    float *heard = ArenaAllocZeroed(&game->frameArena, sizeof(float) * game->maxProtesters);
+    for (int i = 0; i < game->maxProtesters; i++) {
+        Protester *p = &game->protesters[i];
+        if (!p->alive || p->state == ARRESTED) continue;
+        activeProtesters++;
+        p->face_right = (p->vel.x >= 0);
+
+        Vector2 targetForce = {0, 0};
+        if (Vector2Distance(p->pos, p->target_pos) > 10.0f) {
+            targetForce = Vector2Scale(Vector2Normalize(Vector2Subtract(p->target_pos, p->pos)), 0.8f);
+        }
+
+        Vector2 stateForce = {0, 0};
+        float speedMultiplier = 1.0f;
+        switch (p->state) {
+            case CHANT:
+                chantingCount++;
+                speedMultiplier = 0.1f;
+                for (int j = 0; j < game->maxProtesters && heard != NULL; j++) {
+                    if (i != j && PackedAlive(game->crowd[j]) &&
+                        Vector2Distance(p->pos, PackedPosition(game->crowd[j], game->worldWidth)) < 60.0f) {
+                        heard[j] += 0.1f;
+                    }
+                }
+                break;
+            case RIOT:
+                speedMultiplier = 2.0f;
+                float closestDist = 9999.0f;
+                Vector2 closestTarget = p->pos;
+                for (int j = 0; j < game->maxPolice; j++) {
+                    if (game->police[j].alive) {
+                        float dist = Vector2Distance(p->pos, game->police[j].pos);
+                        if (dist < closestDist) {
+                            closestDist = dist;
+                            closestTarget = game->police[j].pos;
+                        }
+                    }
+                }
+                if (closestDist < 9999.0f) {
+                    stateForce = Vector2Scale(Vector2Normalize(Vector2Subtract(closestTarget, p->pos)), 1.5f);
+                }
+                break;
+            case FLEE:
+                speedMultiplier = 3.0f;
+                for (int j = 0; j < game->maxPolice; j++) {
+                    if (game->police[j].alive) {
+                        float dist = Vector2Distance(p->pos, game->police[j].pos);
+                        if (dist < 100.0f) {
+                            Vector2 away = Vector2Scale(Vector2Normalize(Vector2Subtract(p->pos, game->police[j].pos)), 2.0f);
+                            stateForce = Vector2Add(stateForce, away);
+                        }
+                    }
+                }
+                break;
+            case IDLE:
+            default:
+                speedMultiplier = 1.0f;
+                break;
+        }
+        Vector2 totalForce = Vector2Add(targetForce, stateForce);
+        float maxSpeed = 2.5f * speedMultiplier;
+        if (Vector2Length(totalForce) > maxSpeed) {
+            totalForce = Vector2Scale(Vector2Normalize(totalForce), maxSpeed);
+        }
+        p->vel = Vector2Lerp(p->vel, totalForce, 0.3f);
+        p->pos = Vector2Add(p->pos, p->vel);
+        p->pos.x = Clamp(p->pos.x, FIELD_MARGIN, game->worldWidth - FIELD_MARGIN);
+        p->pos.y = Clamp(p->pos.y, FIELD_TOP, FIELD_BOTTOM);
+        if (p->state == CHANT) p->morale += 0.2f;
+        if (p->state == FLEE) p->morale -= 0.5f;
+        p->morale = Clamp(p->morale, 0.0f, 100.0f);
+
+        if (p->state == RIOT) {
+            for (int k = 0; k < game->maxPolice; k++) {
+                if (game->police[k].alive && Vector2Distance(p->pos, game->police[k].pos) < 20.0f) {
+                    PushGameEvent(game, EVENT_POLICE_HIT, CAUSE_MELEE, k, i, 10.0f * game->dt);
+                }
+            }
+        }
+    }
+
+    for (int j = 0; j < game->maxProtesters && heard != NULL; j++) {
+        if (heard[j] > 0.0f) PushGameEvent(game, EVENT_CHANT_HEARD, CAUSE_NONE, j, -1, heard[j]);
+    }
+    if (chantingCount > 0) {
+        PushGameEvent(game, EVENT_CHANT, CAUSE_NONE, -1, -1, (float)chantingCount * 0.1f);
+    }
+
+    game->protesterCount = activeProtesters;
+}
+
+// A free gas slot for the squad, -1 if none. With fewer canisters than
+// squads most squads own no slot, so any squad short of a free one of its
+// own may then take any free canister.
+static int FreeGasSlot(const GameState *game, const Squad *squad)
+{
+    for (int g = squad->firstGas; g < squad->firstGas + squad->gasCount; g++) {
+        if (!game->gas[g].active) return g;
+    }
+    if (game->maxGas >= game->squadCount) return -1;
+    for (int g = 0; g < game->maxGas; g++) {
+        if (!game->gas[g].active) return g;
+    }
+    return -1;
+}
+
+// One perception and decision pass for a squad: where its members stand,
+// which protesters they can see, and what the line does about them
+static void PlanSquad(GameState *game, int s)
+{
+    Squad *squad = &game->squads[s];
+    int first = s * SQUAD_SIZE;
+    int last = (first + SQUAD_SIZE < game->maxPolice) ? first + SQUAD_SIZE : game->maxPolice;
+    Vector2 centroid = {0, 0};
+    int members = 0;
+    for (int i = first; i < last; i++) {
+        if (!game->police[i].alive) continue;
+        centroid = Vector2Add(centroid, game->police[i].pos);
+        members++;
+    }
+    if (members == 0) return; // nothing to plan until reinforcements fill its slots
+    centroid = Vector2Scale(centroid, 1.0f / members);
+
+    // The nearest protester is the squad's firing target; those not fleeing
+    // form the cluster it faces and gasses
+    Vector2 cluster = {0, 0};
+    int clusterCount = 0;
+    float nearestDist = SQUAD_PERCEPTION;
+    float nearestActiveDist = SQUAD_PERCEPTION;
+    squad->targetIndex = -1;
+    for (int j = 0; j < game->maxProtesters; j++) {
+        if (!PackedAlive(game->crowd[j])) continue;
+        Vector2 pos = PackedPosition(game->crowd[j], game->worldWidth);
+        float dist = Vector2Distance(centroid, pos);
+        if (dist >= SQUAD_PERCEPTION) continue;
+        if (dist < nearestDist) {
+            nearestDist = dist;
+            squad->targetIndex = j;
+        }
+        if (PackedState(game->crowd[j]) == FLEE) continue;
+        if (dist < nearestActiveDist) nearestActiveDist = dist;
+        cluster = Vector2Add(cluster, pos);
+        clusterCount++;
+    }
+    if (clusterCount > 0) {
+        cluster = Vector2Scale(cluster, 1.0f / clusterCount);
+        Vector2 toCluster = Vector2Subtract(cluster, centroid);
+        if (Vector2Length(toCluster) > 1.0f) squad->facing = Vector2Normalize(toCluster);
+    }
+
+    switch (squad->order) {
+    case PATROL:
+        if (Vector2Distance(centroid, squad->waypoint) < 30.0f) {
+            squad->waypoint = (Vector2){GameRandom(game, (int)(game->worldWidth * 0.5f), (int)game->worldWidth - 100),
+                                        Clamp(centroid.y + GameRandom(game, -80, 80), FIELD_TOP, FIELD_BOTTOM)};
+        }
+        squad->anchor = squad->waypoint;
+        if (nearestActiveDist < 150.0f) {
+            squad->order = DEPLOY;
+            squad->deployEnd = game->time + 3.0;
+        }
+        break;
+    case DEPLOY:
+        // Hold the line where it stands and gas the cluster
+        squad->anchor = centroid;
+        if (nearestActiveDist < 200.0f) {
+            int g = FreeGasSlot(game, squad);
+            if (g >= 0) {
+                game->gas[g].pos = cluster;
+                game->gas[g].radius = 5.0f;
+                game->gas[g].timer = 0.0f;
+                game->gas[g].active = true;
+                PlayGameSound(game, SFX_GAS, cluster);
+                EmitParticles(game, PARTICLES_GAS, cluster, (Vector2){0, -1});
+            }
+        }
+        if (game->time >= squad->deployEnd) squad->order = PATROL;
+        break;
+    case ARREST:
+        squad->anchor = centroid;
+        break;
+    default: // INTERVENE follows the surge centre, set every tick by UpdatePolice
+        break;
+    }
+}
+
+// Members only steer to their place in the squad's line and fire on the
+// squad's target; the deciding is done in PlanSquad
+void UpdatePolice(GameState *game)
+{
+    // A surge sends every squad to the same place, so find it once
+    Vector2 centerOfProtest = {0, 0};
+    int protestCount = 0;
+    if (game->policeSurgeActive) {
+        for (int j = 0; j < game->maxProtesters; j++) {
+            if (PackedAlive(game->crowd[j]) && PackedState(game->crowd[j]) != FLEE) {
+                centerOfProtest = Vector2Add(centerOfProtest, PackedPosition(game->crowd[j], game->worldWidth));
+                protestCount++;
+            }
+        }
+        if (protestCount > 0) centerOfProtest = Vector2Scale(centerOfProtest, 1.0f / protestCount);
+    }
+
+    int activePolice = 0;
+    for (int s = 0; s < game->squadCount; s++) {
+        Squad *squad = &game->squads[s];
+        int first = s * SQUAD_SIZE;
+        int last = (first + SQUAD_SIZE < game->maxPolice) ? first + SQUAD_SIZE : game->maxPolice;
+        int members = 0;
+        for (int i = first; i < last; i++) members += game->police[i].alive ? 1 : 0;
+        if (members == 0) continue;
+
+        if (squad->order == INTERVENE && protestCount > 0) squad->anchor = centerOfProtest;
+        bool hasTarget = squad->targetIndex != -1 && PackedAlive(game->crowd[squad->targetIndex]);
+        Vector2 target = hasTarget ? PackedPosition(game->crowd[squad->targetIndex], game->worldWidth) : (Vector2){0, 0};
+        Vector2 across = {-squad->facing.y, squad->facing.x};
+        float speed = (squad->order == INTERVENE) ? 2.0f : 1.0f;
+
+        int rank = 0;
+        for (int i = first; i < last; i++) {
+            Police *p = &game->police[i];
+            if (!p->alive) continue;
+            activePolice++;
+            p->state = squad->order;
+            p->face_right = (p->vel.x >= 0);
+
+            if (hasTarget && Vector2Distance(p->pos, target) < 120.0f && !TimerPending(game, TIMER_POLICE_COOLDOWN, p->id)) {
+                ShootBullet(game, p, target);
+            }
+
+            Vector2 slot = Vector2Add(squad->anchor, Vector2Scale(across, (rank - (members - 1) * 0.5f) * SQUAD_SPACING));
+            Vector2 toSlot = Vector2Subtract(slot, p->pos);
+            if (Vector2Length(toSlot) > 5.0f) {
+                p->vel = Vector2Scale(Vector2Normalize(toSlot), speed);
+            } else {
+                p->vel = Vector2Scale(p->vel, 0.9f);
+            }
+            rank++;
+
+            if (squad->order == ARREST) {
+                for (int j = 0; j < game->maxProtesters; j++) {
+                    if (PackedAlive(game->crowd[j]) && PackedState(game->crowd[j]) == FLEE &&
+                        Vector2Distance(p->pos, PackedPosition(game->crowd[j], game->worldWidth)) < 25.0f) {
+                        PushGameEvent(game, EVENT_ARREST, CAUSE_NONE, j, i, 0.0f);
+                        squad->order = PATROL;
+                        break;
+                    }
+                }
+            }
+
+            p->pos = Vector2Add(p->pos, p->vel);
+            p->pos.x = Clamp(p->pos.x, FIELD_MARGIN, game->worldWidth - FIELD_MARGIN);
+            p->pos.y = Clamp(p->pos.y, FIELD_TOP, FIELD_BOTTOM);
+        }
+    }
+    game->policeCount = activePolice;
+}
+
+void UpdateTearGas(GameState *game)
+{
+    for (int g = 0; g < game->maxGas; g++)
+    {
+        if (game->gas[g].active)
+        {
+            game->gas[g].radius += 25.0f * game->dt;
+            game->gas[g].timer += game->dt;
+
+            for (int j = 0; j < game->maxProtesters; j++)
+            {
+                if (!PackedAlive(game->crowd[j]) || PackedState(game->crowd[j]) == FLEE)
+                    continue;
+
+                float dist = Vector2Distance(game->gas[g].pos, PackedPosition(game->crowd[j], game->worldWidth));
+                if (dist < game->gas[g].radius)
+                {
+                    PushGameEvent(game, EVENT_GAS_EXPOSURE, CAUSE_GAS, j, g, 15.0f);
+                }
+            }
+
+            if (game->gas[g].timer > 5.0f || game->gas[g].radius > 100.0f)
+            {
+                game->gas[g].active = false;
+            }
+        }
+    }
+}
+
+// Live officers bucketed by position, built once per order so every stone
+// in it can find its nearest target without scanning the whole force
+typedef struct
+{
+    int columns;
+    int rows;
+    int *cellStart; // columns * rows + 1 offsets into indices
+    int *indices;   // police slots ordered by cell
+} PoliceGrid;
+
+bool BuildPoliceGrid(GameState *game, PoliceGrid *grid)
+{
+    grid->columns = (int)ceilf(game->worldWidth / POLICE_GRID_CELL);
+    grid->rows = (int)ceilf(WORLD_HEIGHT / POLICE_GRID_CELL);
+    int cells = grid->columns * grid->rows;
+    grid->cellStart = ArenaAllocZeroed(&game->frameArena, sizeof(int) * (cells + 1));
+    grid->indices = ArenaAlloc(&game->frameArena, sizeof(int) * game->maxPolice);
+    int *cellOf = ArenaAlloc(&game->frameArena, sizeof(int) * game->maxPolice);
+    if (grid->cellStart == NULL || grid->indices == NULL || cellOf == NULL) return false;
+
+    // Counting sort: tally each cell, prefix-sum, then scatter
+    for (int i = 0; i < game->maxPolice; i++) {
+        cellOf[i] = -1;
+        if (!game->police[i].alive) continue;
+        int cx = (int)Clamp(game->police[i].pos.x / POLICE_GRID_CELL, 0, grid->columns - 1);
+        int cy = (int)Clamp(game->police[i].pos.y / POLICE_GRID_CELL, 0, grid->rows - 1);
+        cellOf[i] = cy * grid->columns + cx;
+        grid->cellStart[cellOf[i] + 1]++;
+    }
+    for (int c = 0; c < cells; c++) grid->cellStart[c + 1] += grid->cellStart[c];
+    int *fill = ArenaAlloc(&game->frameArena, sizeof(int) * cells);
+    if (fill == NULL) return false;
+    memcpy(fill, grid->cellStart, sizeof(int) * cells);
+    for (int i = 0; i < game->maxPolice; i++) {
+        if (cellOf[i] >= 0) grid->indices[fill[cellOf[i]]++] = i;
+    }
+    return true;
+}
+
+// Searches rings of cells outward from pos; stops once no unvisited cell
+// can hold anyone closer than the best found. Returns -1 if nobody is left.
+int NearestPolice(const GameState *game, const PoliceGrid *grid, Vector2 pos)
+{
+    int cx = (int)Clamp(pos.x / POLICE_GRID_CELL, 0, grid->columns - 1);
+    int cy = (int)Clamp(pos.y / POLICE_GRID_CELL, 0, grid->rows - 1);
+    int maxRing = (grid->columns > grid->rows) ? grid->columns : grid->rows;
+    int best = -1;
+    float bestDist = 0.0f;
+
+    for (int ring = 0; ring < maxRing; ring++) {
+        for (int y = cy - ring; y <= cy + ring; y++) {
+            if (y < 0 || y >= grid->rows) continue;
+            bool edgeRow = (y == cy - ring || y == cy + ring);
+            for (int x = cx - ring; x <= cx + ring; x += edgeRow ? 1 : 2 * ring) {
+                if (x >= 0 && x < grid->columns) {
+                    int cell = y * grid->columns + x;
+                    for (int k = grid->cellStart[cell]; k < grid->cellStart[cell + 1]; k++) {
+                        float dist = Vector2Distance(pos, game->police[grid->indices[k]].pos);
+                        if (best < 0 || dist < bestDist) {
+                            best = grid->indices[k];
+                            bestDist = dist;
+                        }
+                    }
+                }
+                if (ring == 0) break;
+            }
+        }
+        if (best >= 0 && bestDist <= ring * POLICE_GRID_CELL) break;
+    }
+    return best;
+}
+
+// Position-based crowd pressure. After UpdateProtesters has moved everyone
+// to their predicted positions, a few Jacobi iterations project protesters
+// out of each other and out of officers. Each iteration reads only the
+// previous iteration's positions, so agents are solved in parallel chunks
+// and the result does not depend on the thread count. Corrections from all
+// of an agent's contacts are averaged and over-relaxed, which keeps dense
+// crowds from jittering; what the constraints move is fed back into the
+// velocity, so pressure carries through the crowd on later ticks.
+typedef struct
+{
+    int columns; // agent grid over the walkable field, one contact distance per cell
+    int rows;
+    int *cellStart; // columns * rows + 1 offsets into the agent arrays
+    PoliceGrid police;
+    int count;
+    int *slots;      // protester slot of each agent, agents ordered by cell
+    bool *rioting;   // rioters may close in on officers
+    Vector2 *read;   // positions from the previous iteration
+    Vector2 *write;
+} CrowdSolver;
+
+static inline int CrowdCell(const CrowdSolver *solver, Vector2 pos, int *cx, int *cy)
+{
+    *cx = (int)Clamp(pos.x / (2.0f * CROWD_AGENT_RADIUS), 0, solver->columns - 1);
+    *cy = (int)Clamp((pos.y - FIELD_TOP) / (2.0f * CROWD_AGENT_RADIUS), 0, solver->rows - 1);
+    return *cy * solver->columns + *cx;
+}
+
+int CrowdGridCells(float worldWidth)
+{
+    int columns = (int)ceilf(worldWidth / (2.0f * CROWD_AGENT_RADIUS));
+    int rows = (int)ceilf((FIELD_BOTTOM - FIELD_TOP) / (2.0f * CROWD_AGENT_RADIUS)) + 1;
+    return columns * rows;
+}
+
+static bool BuildCrowdSolver(GameState *game, CrowdSolver *solver)
+{
+    solver->columns = (int)ceilf(game->worldWidth / (2.0f * CROWD_AGENT_RADIUS));
+    solver->rows = CrowdGridCells(game->worldWidth) / solver->columns;
+    int cells = solver->columns * solver->rows;
+    int n = game->maxProtesters;
+    solver->cellStart = ArenaAllocZeroed(&game->frameArena, sizeof(int) * (cells + 1));
+    solver->slots = ArenaAlloc(&game->frameArena, sizeof(int) * n);
+    solver->rioting = ArenaAlloc(&game->frameArena, sizeof(bool) * n);
+    solver->read = ArenaAlloc(&game->frameArena, sizeof(Vector2) * n);
+    solver->write = ArenaAlloc(&game->frameArena, sizeof(Vector2) * n);
+    int *cellOf = ArenaAlloc(&game->frameArena, sizeof(int) * n);
+    if (solver->cellStart == NULL || solver->slots == NULL || solver->rioting == NULL ||
+        solver->read == NULL || solver->write == NULL || cellOf == NULL || !BuildPoliceGrid(game, &solver->police)) {
+        return false;
+    }
+
+    // Counting sort by cell, so neighbours are contiguous in the agent arrays
+    for (int i = 0; i < n; i++) {
+        int cx, cy;
+        cellOf[i] = -1;
+        if (!game->protesters[i].alive) continue;
+        cellOf[i] = CrowdCell(solver, game->protesters[i].pos, &cx, &cy);
+        solver->cellStart[cellOf[i] + 1]++;
+    }
+    for (int c = 0; c < cells; c++) solver->cellStart[c + 1] += solver->cellStart[c];
+    solver->count = solver->cellStart[cells];
+    int *fill = ArenaAlloc(&game->frameArena, sizeof(int) * cells);
+    if (fill == NULL) return false;
+    memcpy(fill, solver->cellStart, sizeof(int) * cells);
+    for (int i = 0; i < n; i++) {
+        if (cellOf[i] < 0) continue;
+        int k = fill[cellOf[i]]++;
+        solver->slots[k] = i;
+        solver->rioting[k] = (game->protesters[i].state == RIOT);
+        solver->read[k] = game->protesters[i].pos;
+    }
+    return true;
+}
+
+typedef struct
+{
+    const GameState *game;
+    const CrowdSolver *solver;
+} CrowdIteration;
+
+static void SolveCrowdChunk(void *context, int chunk)
+{
+    const CrowdIteration *iteration = (const CrowdIteration *)context;
+    const GameState *game = iteration->game;
+    const CrowdSolver *solver = iteration->solver;
+    const float contact = 2.0f * CROWD_AGENT_RADIUS;
+    int end = (chunk + 1) * CROWD_CHUNK < solver->count ? (chunk + 1) * CROWD_CHUNK : solver->count;
+
+    for (int k = chunk * CROWD_CHUNK; k < end; k++) {
+        Vector2 pos = solver->read[k];
+        Vector2 correction = {0, 0};
+        int contacts = 0;
+
+        int cx, cy;
+        CrowdCell(solver, pos, &cx, &cy);
+        for (int y = cy - 1; y <= cy + 1; y++) {
+            if (y < 0 || y >= solver->rows) continue;
+            for (int x = cx - 1; x <= cx + 1; x++) {
+                if (x < 0 || x >= solver->columns) continue;
+                int cell = y * solver->columns + x;
+                for (int j = solver->cellStart[cell]; j < solver->cellStart[cell + 1]; j++) {
+                    if (j == k) continue;
+                    Vector2 d = Vector2Subtract(pos, solver->read[j]);
+                    float distSq = d.x * d.x + d.y * d.y;
+                    if (distSq >= contact * contact) continue;
+                    float dist = sqrtf(distSq);
+                    if (dist > 1e-4f) {
+                        correction = Vector2Add(correction, Vector2Scale(d, 0.5f * (contact - dist) / dist));
+                    } else {
+                        // Coincident pair: split along x, in opposite directions for the two
+                        correction.x += (k < j) ? -0.5f * contact : 0.5f * contact;
+                    }
+                    contacts++;
+                }
+            }
+        }
+
+        // Officers do not yield, so the protester takes the whole correction
+        const PoliceGrid *grid = &solver->police;
+        int px = (int)Clamp(pos.x / POLICE_GRID_CELL, 0, grid->columns - 1);
+        int py = (int)Clamp(pos.y / POLICE_GRID_CELL, 0, grid->rows - 1);
+        float clearance = solver->rioting[k] ? CROWD_AGENT_RADIUS + CROWD_POLICE_RADIUS : CROWD_PERSONAL_SPACE;
+        for (int y = py - 1; y <= py + 1; y++) {
+            if (y < 0 || y >= grid->rows) continue;
+            for (int x = px - 1; x <= px + 1; x++) {
+                if (x < 0 || x >= grid->columns) continue;
+                int cell = y * grid->columns + x;
+                for (int m = grid->cellStart[cell]; m < grid->cellStart[cell + 1]; m++) {
+                    Vector2 d = Vector2Subtract(pos, game->police[grid->indices[m]].pos);
+                    float distSq = d.x * d.x + d.y * d.y;
+                    if (distSq >= clearance * clearance || distSq < 1e-8f) continue;
+                    float dist = sqrtf(distSq);
+                    correction = Vector2Add(correction, Vector2Scale(d, (clearance - dist) / dist));
+                    contacts++;
+                }
+            }
+        }
+
+        if (contacts > 0) pos = Vector2Add(pos, Vector2Scale(correction, CROWD_RELAXATION / contacts));
+        pos.x = Clamp(pos.x, FIELD_MARGIN, game->worldWidth - FIELD_MARGIN);
+        pos.y = Clamp(pos.y, FIELD_TOP, FIELD_BOTTOM);
+        solver->write[k] = pos;
+    }
+}
+
+void SolveCrowdConstraints(GameState *game)
+{
+    CrowdSolver solver = {0};
+    if (!BuildCrowdSolver(game, &solver) || solver.count == 0) return;
+
+    CrowdIteration iteration = {game, &solver};
+    int chunks = (solver.count + CROWD_CHUNK - 1) / CROWD_CHUNK;
+    for (int it = 0; it < game->scenario.crowdIterations; it++) {
+        RunParallel(game->workers, chunks, SolveCrowdChunk, &iteration);
+        Vector2 *swap = solver.read;
+        solver.read = solver.write;
+        solver.write = swap;
+    }
+
+    // Vehicles are hard constraints, applied last so no one ends the tick
+    // inside one. Only the grid cells under a vehicle's swept box are
+    // visited, with a cell of margin for agents that moved since binning.
+    for (int i = 0; i < VEHICLE_CAPACITY; i++) {
+        Vehicle *v = &game->vehicles[i];
+        if (!v->active) continue;
+        SweptBox box = VehicleSweep(v);
+        Rectangle bounds = SweptBounds(&box, 3.0f * CROWD_AGENT_RADIUS);
+        int x0, y0, x1, y1;
+        CrowdCell(&solver, (Vector2){bounds.x, bounds.y}, &x0, &y0);
+        CrowdCell(&solver, (Vector2){bounds.x + bounds.width, bounds.y + bounds.height}, &x1, &y1);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                int cell = y * solver.columns + x;
+                for (int k = solver.cellStart[cell]; k < solver.cellStart[cell + 1]; k++) {
+                    Vector2 *pos = &solver.read[k];
+                    if (!PushOutOfSweep(&box, pos, CROWD_AGENT_RADIUS, false)) continue;
+                    if (pos->x < FIELD_MARGIN || pos->x > game->worldWidth - FIELD_MARGIN) {
+                        pos->x = Clamp(pos->x, FIELD_MARGIN, game->worldWidth - FIELD_MARGIN);
+                        PushOutOfSweep(&box, pos, CROWD_AGENT_RADIUS, true); // pinned at the world's edge
+                    }
+                    pos->y = Clamp(pos->y, FIELD_TOP, FIELD_BOTTOM);
+                    v->contacts++;
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < solver.count; k++) {
+        Protester *p = &game->protesters[solver.slots[k]];
+        p->vel = Vector2Add(p->vel, Vector2Subtract(solver.read[k], p->pos));
+        p->vel = Vector2ClampValue(p->vel, 0.0f, PROTESTER_MAX_SPEED);
+        p->pos = solver.read[k];
+    }
+}
+
+void LaunchStone(GameState *game, int idx, Vector2 pos, Vector2 targetDir, int owner_id) {
+    game->projectiles[idx].active = true;
+    game->projectiles[idx].pos = pos;
+    Vector2 norm = Vector2Normalize(targetDir);
+    if (Vector2Length(norm) < 0.01f) norm = (Vector2){1,0};
+    game->projectiles[idx].vel = Vector2Scale(norm, 350.0f);
+    game->projectiles[idx].owner_id = owner_id;
+    game->projectiles[idx].lifetime = 0.0f;
+    game->projectiles[idx].distance = 0.0f;
+    game->projectiles[idx].max_distance = 320.0f;
+    game->projectiles[idx].type = STONE;
+    game->projectiles[idx].damage = 25.0f;
+    PlayGameSound(game, SFX_STONE, pos);
+}
+
+void ShootBullet(GameState *game, Police* p, Vector2 target) {
+    if (TimerPending(game, TIMER_POLICE_COOLDOWN, p->id)) return;
+    for (int i = 0; i < game->maxProjectiles; i++) {
+        if (!game->projectiles[i].active) {
+            game->projectiles[i].pos = p->pos;
+            Vector2 dir = Vector2Normalize(Vector2Subtract(target, p->pos));
+            float angle = GameRandom(game, -5, 5) * DEG2RAD;
+            game->projectiles[i].vel = Vector2Scale(Vector2Rotate(dir, angle), 350.0f);
+            game->projectiles[i].owner_id = p->id;
+            game->projectiles[i].lifetime = 0.0f;
+            game->projectiles[i].active = true;
+            game->projectiles[i].type = BULLET;
+            game->projectiles[i].damage = 30.0f;
+            game->projectiles[i].distance = 0.0f;
+            game->projectiles[i].max_distance = 320.0f;
+            ScheduleTimer(game, TIMER_POLICE_COOLDOWN, p->id, POLICE_SHOT_COOLDOWN);
+            PlayGameSound(game, SFX_BULLET, p->pos);
+            EmitParticles(game, PARTICLES_MUZZLE, p->pos, dir);
+            break;
+        }
+    }
+}
+
+typedef enum
+{
+    ORDER_MOVE = 1,   // walk towards the target
+    ORDER_CYCLE = 2,  // Idle -> Chant -> Riot -> Idle
+    ORDER_THROW = 4,  // stone at the nearest officer, or towards the target
+    ORDER_RETREAT = 8 // flee to the left edge
+} OrderFlags;
+
+// Applies one order to the whole selection in a single pass. Projectile
+// slots are gathered once up front and the nearest-officer lookups share
+// one police grid, so the cost is linear in the selection size.
+void IssueSelectionOrder(GameState *game, int flags, Vector2 target)
+{
+    PoliceGrid grid = {0};
+    int *freeSlots = NULL;
+    int freeCount = 0;
+    if (flags & ORDER_THROW) {
+        freeSlots = ArenaAlloc(&game->frameArena, sizeof(int) * game->maxProjectiles);
+        if (freeSlots != NULL && BuildPoliceGrid(game, &grid)) {
+            for (int i = 0; i < game->maxProjectiles; i++) {
+                if (!game->projectiles[i].active) freeSlots[freeCount++] = i;
+            }
+        }
+    }
+
+    int words = SelectionWords(game);
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = game->selected[w];
+        while (bits != 0) {
+            int i = w * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            Protester *p = &game->protesters[i];
+            if (!p->alive) continue;
+
+            if (flags & ORDER_MOVE) p->target_pos = target;
+            if (flags & ORDER_CYCLE) {
+                switch (p->state) {
+                case IDLE: p->state = CHANT; break;
+                case CHANT: p->state = RIOT; break;
+                case RIOT: p->state = IDLE; break;
+                case FLEE:
+                    p->state = IDLE;
+                    CancelTimer(game, TIMER_FLEE_END, i);
+                    break;
+                default: break;
+                }
+            }
+            if (flags & ORDER_RETREAT) {
+                if (p->state != FLEE) ScheduleTimer(game, TIMER_FLEE_END, i, FLEE_DURATION);
+                p->state = FLEE;
+                p->target_pos = (Vector2){50, p->pos.y};
+            }
+            if ((flags & ORDER_THROW) && freeCount > 0 && !TimerPending(game, TIMER_STONE_COOLDOWN, i)) {
+                int officer = NearestPolice(game, &grid, p->pos);
+                Vector2 dir = (officer >= 0) ? Vector2Subtract(game->police[officer].pos, p->pos) : Vector2Subtract(target, p->pos);
+                LaunchStone(game, freeSlots[--freeCount], p->pos, dir, i);
+                ScheduleTimer(game, TIMER_STONE_COOLDOWN, i, STONE_COOLDOWN);
+            }
+        }
+    }
+}
+
+// The person at the window. The main loop stamps polledAt each time raylib
+// collects input events.
+typedef struct
+{
+    InputSource source; // first, so it can be installed as an InputSource
+    double polledAt;
+} PlayerInput;
+
+static void PollPlayerInput(InputSource *source, const GameState *game, InputState *input)
+{
+    input->sampledAt = ((PlayerInput *)source)->polledAt;
+    input->mouseWorld = GetScreenToWorld2D(GetMousePosition(), game->camera);
+    input->selectPressed = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+    input->selectDown = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    input->selectReleased = IsMouseButtonReleased(MOUSE_LEFT_BUTTON);
+    input->commandPressed = IsMouseButtonPressed(MOUSE_RIGHT_BUTTON);
+    input->selectAllPressed = IsKeyPressed(KEY_A);
+    input->retreatPressed = IsKeyPressed(KEY_SPACE);
+    input->throwPressed = IsKeyPressed(KEY_T);
+    input->barricadePressed = IsKeyPressed(KEY_B);
+}
+
+PlayerInput playerInput = {{PollPlayerInput}, 0.0};
+
+// Scripted stand-in for a player, for unattended soak and load runs. It
+// produces the same InputState a player would: box selections dragged over
+// about `crowd` protesters (or select-all), right-click orders that cycle
+// states and fire stones, T volleys and SPACE retreats, each at its own
+// rate with jittered spacing. Deterministic for a given seed.
+typedef enum
+{
+    BOT_SELECT,
+    BOT_ORDER,
+    BOT_VOLLEY,
+    BOT_RETREAT,
+    BOT_ACTION_COUNT
+} BotAction;
+
+typedef struct
+{
+    InputSource source; // first, so the bot can be installed as an InputSource
+    uint64_t rng;
+    int crowd;
+    float interval[BOT_ACTION_COUNT]; // mean seconds between actions, 0 if disabled
+    double next[BOT_ACTION_COUNT];
+    double clock;
+    bool dragging; // mid box selection, released on the next poll
+    Vector2 dragEnd;
+    int selections;
+} SyntheticPlayer;
+
+static double NextBotAction(SyntheticPlayer *bot, BotAction action)
+{
+    // Uniform in [0.5, 1.5] of the mean interval
+    return bot->clock + bot->interval[action] * NextRandom(&bot->rng, 500, 1500) / 1000.0;
+}
+
+// Box around a random live protester, grown until it holds about
+// bot->crowd of them
+static void PlanBotSelection(SyntheticPlayer *bot, const GameState *game, Vector2 *start, Vector2 *end)
+{
+    Vector2 center = {game->worldWidth * 0.25f, (FIELD_TOP + FIELD_BOTTOM) * 0.5f};
+    for (int tries = 0; tries < 8; tries++) {
+        int j = NextRandom(&bot->rng, 0, game->maxProtesters - 1);
+        if (PackedAlive(game->crowd[j])) {
+            center = PackedPosition(game->crowd[j], game->worldWidth);
+            break;
+        }
+    }
+    float half = 16.0f;
+    for (; half < game->worldWidth; half *= 2.0f) {
+        int inside = 0;
+        for (int j = 0; j < game->maxProtesters && inside < bot->crowd; j++) {
+            Vector2 pos = PackedPosition(game->crowd[j], game->worldWidth);
+            if (PackedAlive(game->crowd[j]) && fabsf(pos.x - center.x) <= half && fabsf(pos.y - center.y) <= half) inside++;
+        }
+        if (inside >= bot->crowd) break;
+    }
+    *start = (Vector2){center.x - half, center.y - half};
+    *end = (Vector2){center.x + half, center.y + half};
+}
+
+static void PollSyntheticPlayer(InputSource *source, const GameState *game, InputState *input)
+{
+    SyntheticPlayer *bot = (SyntheticPlayer *)source;
+    bot->clock += game->dt;
+    if (bot->dragging) {
+        input->mouseWorld = bot->dragEnd;
+        input->selectReleased = true;
+        bot->dragging = false;
+        return;
+    }
+
+    Vector2 field = {
+        (float)NextRandom(&bot->rng, FIELD_MARGIN, (int)game->worldWidth - FIELD_MARGIN),
+        (float)NextRandom(&bot->rng, FIELD_TOP, FIELD_BOTTOM)
+    };
+    input->mouseWorld = field;
+    for (int action = 0; action < BOT_ACTION_COUNT; action++) {
+        if (bot->interval[action] <= 0.0f || bot->clock < bot->next[action]) continue;
+        bot->next[action] = NextBotAction(bot, (BotAction)action);
+        switch (action) {
+            case BOT_SELECT:
+                if (bot->selections++ % 4 == 3) {
+                    input->selectAllPressed = true;
+                } else {
+                    PlanBotSelection(bot, game, &input->mouseWorld, &bot->dragEnd);
+                    input->selectPressed = true;
+                    input->selectDown = true;
+                    bot->dragging = true;
+                    return; // the drag owns the cursor until it is released
+                }
+                break;
+            case BOT_ORDER:
+                input->commandPressed = true;
+                break;
+            case BOT_VOLLEY:
+                input->throwPressed = true;
+                break;
+            case BOT_RETREAT:
+                input->retreatPressed = true;
+                break;
+        }
+    }
+}
+
+void InitSyntheticPlayer(SyntheticPlayer *bot, const ScenarioConfig *scenario)
+{
+    memset(bot, 0, sizeof(SyntheticPlayer));
+    bot->source.poll = PollSyntheticPlayer;
+    bot->rng = SeedRandom((uint64_t)scenario->seed ^ 0xB07B07B07ull); // apart from the game's own stream
+    bot->crowd = scenario->botCrowd;
+    int rates[BOT_ACTION_COUNT] = {scenario->botSelectRate, scenario->botOrderRate, scenario->botVolleyRate, scenario->botRetreatRate};
+    for (int action = 0; action < BOT_ACTION_COUNT; action++) {
+        bot->interval[action] = (rates[action] > 0) ? 60.0f / rates[action] : 0.0f;
+        bot->next[action] = (rates[action] > 0) ? NextBotAction(bot, (BotAction)action) : 0.0;
+    }
+}
+
+void HandleInput(GameState *game)
+{
+    const InputState *input = &game->input;
+    if (input->selectPressed)
+    {
+        game->isSelecting = true;
+        game->selectStart = input->mouseWorld;
+        game->selectEnd = game->selectStart;
+    }
+
+    if (game->isSelecting && input->selectDown)
+    {
+        game->selectEnd = input->mouseWorld;
+    }
+
+    if (game->isSelecting && input->selectReleased)
+    {
+        float minX = fminf(game->selectStart.x, game->selectEnd.x);
+        float maxX = fmaxf(game->selectStart.x, game->selectEnd.x);
+        float minY = fminf(game->selectStart.y, game->selectEnd.y);
+        float maxY = fmaxf(game->selectStart.y, game->selectEnd.y);
+
+        int words = SelectionWords(game);
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t bits = 0;
+            int end = (w * 64 + 64 < game->maxProtesters) ? w * 64 + 64 : game->maxProtesters;
+            for (int i = w * 64; i < end; i++)
+            {
+                Vector2 pos = game->protesters[i].pos;
+                if (game->protesters[i].alive && pos.x >= minX && pos.x <= maxX && pos.y >= minY && pos.y <= maxY)
+                    bits |= 1ull << (i & 63);
+            }
+            game->selected[w] = bits;
+        }
+        game->isSelecting = false;
+    }
+
+    if (input->commandPressed)
+    {
+        IssueSelectionOrder(game, ORDER_MOVE | ORDER_CYCLE | ORDER_THROW, input->mouseWorld);
+    }
+
+    if (input->selectAllPressed)
+    {
+        memset(game->selected, 0, sizeof(uint64_t) * SelectionWords(game));
+        for (int i = 0; i < game->maxProtesters; i++)
+        {
+            if (game->protesters[i].alive)
+                game->selected[i >> 6] |= 1ull << (i & 63);
+        }
+    }
+
+    if (input->retreatPressed)
+    {
+        IssueSelectionOrder(game, ORDER_RETREAT, (Vector2){0, 0});
+    }
+
+    if (input->throwPressed) {
+        IssueSelectionOrder(game, ORDER_THROW, input->mouseWorld);
+    }
+
+    if (input->barricadePressed) {
+        ToggleBarricade(game, input->mouseWorld);
+    }
+}
+
+bool CheckWinCondition(GameState *game)
+{
+    // Calculate territory control (also shown by the HUD)
+    int advancedProtesters = 0;
+    for (int i = 0; i < game->maxProtesters; i++)
+    {
+        if (PackedAlive(game->crowd[i]) && PackedPosition(game->crowd[i], game->worldWidth).x > game->worldWidth * 0.5f)
+        {
+            advancedProtesters++;
+        }
+    }
+
+    float controlPercentage = game->protesterCount > 0 ? (float)advancedProtesters / game->protesterCount : 0.0f;
+    game->controlProgress = controlPercentage;
+
+    // Win if all police are defeated and no reinforcements are still due
+    if (game->policeCount == 0 && !ReinforcementsDue(game)) {
+        return true;
+    }
+
+    // Lowered threshold for morale and control percentage to make winning more achievable
+    if (game->globalMorale > 60.0f && controlPercentage > 0.5f)
+    {
+        if (game->controlStartTime == 0)
+        {
+            game->controlStartTime = game->time;
+            ScheduleTimer(game, TIMER_CONTROL_HOLD, 0, CONTROL_HOLD_TIME); // Reduced time to hold control
+        }
+        else if (!TimerPending(game, TIMER_CONTROL_HOLD, 0))
+        {
+            return true;
+        }
+    }
+    else
+    {
+        game->controlStartTime = 0;
+        CancelTimer(game, TIMER_CONTROL_HOLD, 0);
+    }
+
+    return false;
+}
+
+bool CheckLoseCondition(GameState *game)
+{
+    double elapsed = game->time - game->gameStartTime;
+    return (game->globalMorale < 10.0f ||
+            game->protesterCount < game->protesterArrivals / 5 ||
+            elapsed > GAME_DURATION);
+}
+
+static void StartPoliceSurge(GameState *game, bool start)
+{
+    game->policeSurgeActive = start;
+    if (start) game->policeSurgeEnd = game->time + SURGE_DURATION;
+    for (int s = 0; s < game->squadCount; s++)
+    {
+        game->squads[s].order = start ? INTERVENE : PATROL;
+    }
+    for (int i = 0; i < game->maxPolice; i++)
+    {
+        if (game->police[i].alive)
+        {
+            game->police[i].state = start ? INTERVENE : PATROL;
+        }
+    }
+    DeployPoliceVans(game, start);
+    ScheduleTimer(game, TIMER_SURGE, 0, start ? SURGE_DURATION : SURGE_INTERVAL);
+}
+
+static void OnTimerExpired(GameState *game, TimerKind kind, int target)
+{
+    switch (kind) {
+    case TIMER_FLEE_END:
+        if (game->protesters[target].alive && game->protesters[target].state == FLEE) {
+            game->protesters[target].state = IDLE;
+        }
+        break;
+    case TIMER_SURGE:
+        StartPoliceSurge(game, !game->policeSurgeActive);
+        break;
+    case TIMER_HELICOPTER:
+        SpawnHelicopter(game);
+        break;
+    case TIMER_MORALE_DECAY:
+        game->globalMorale -= 0.2f;
+        ScheduleTimer(game, TIMER_MORALE_DECAY, 0, 1.0f);
+        break;
+    case TIMER_WAVE: {
+        const SpawnWave *wave = &game->scenario.waves[target];
+        game->waveRemaining[target] += wave->count;
+        PushFeedMessage(&game->stats, (wave->faction == FACTION_POLICE) ? "Police reinforcements arriving" : "More protesters join the march",
+                        game->time);
+        break;
+    }
+    case TIMER_SQUAD_PLAN:
+        PlanSquad(game, target);
+        ScheduleTimer(game, TIMER_SQUAD_PLAN, target, SQUAD_PLAN_INTERVAL);
+        break;
+    case TIMER_TRAFFIC:
+        SpawnVehicle(game, (GameRandom(game, 0, 3) == 0) ? VEHICLE_BUS : VEHICLE_CAR, target, -1.0f);
+        ScheduleTimer(game, TIMER_TRAFFIC, target, (float)GameRandom(game, VEHICLE_SPAWN_INTERVAL / 2, VEHICLE_SPAWN_INTERVAL * 3 / 2));
+        break;
+    default: // cooldowns and the control hold only matter while pending
+        break;
+    }
+}
+
+// Moves every timer in a coarse slot down to the level its due tick now
+// belongs to
+static void CascadeTimers(TimerWheel *wheel, int level, int slot)
+{
+    int head = TimerSentinel(wheel, level, slot);
+    while (wheel->nodes[head].next != head) {
+        int id = wheel->nodes[head].next;
+        UnlinkTimer(wheel, id);
+        LinkTimer(wheel, id);
+    }
+}
+
+// Fires, in tick order, everything due up to the current simulation time
+void AdvanceTimers(GameState *game)
+{
+    TimerWheel *wheel = &game->timers;
+    uint32_t target = (uint32_t)(game->time * TIMER_TICK_RATE);
+    while (wheel->tick != target) {
+        wheel->tick++;
+        for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            uint32_t mask = (1u << (TIMER_WHEEL_BITS * level)) - 1;
+            if ((wheel->tick & mask) == 0) {
+                CascadeTimers(wheel, level, (wheel->tick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1));
+            }
+        }
+        int head = TimerSentinel(wheel, 0, wheel->tick & (TIMER_WHEEL_SLOTS - 1));
+        while (wheel->nodes[head].next != head) {
+            int id = wheel->nodes[head].next;
+            UnlinkTimer(wheel, id);
+            TimerKind kind = (TimerKind)wheel->nodes[id].kind;
+            OnTimerExpired(game, kind, id - wheel->base[kind]);
+        }
+    }
+}
+
+// Adds the wall-clock time since `start` to a system's telemetry total and
+// returns the current time, so consecutive systems can be chained. A no-op
+// unless the match is being recorded.
+double RecordSystemTime(GameState *game, TelemetryTiming system, double start)
+{
+    if (game->scenario.telemetryPath == NULL) return start;
+    double now = GetTime();
+    game->systemTime[system] += (float)((now - start) * 1000.0);
+    return now;
+}
+
+void UpdateGame(GameState *game, float dt)
+{
+    if (game->menuState != MENU_PLAY)
+        return;
+
+    game->dt = dt;
+    game->time += dt;
+    double t = (game->scenario.telemetryPath != NULL) ? GetTime() : 0.0; // see RecordSystemTime
+    game->animTime += dt;
+    game->timedTicks++;
+    BeginEventQueue(game);
+    AdvanceTimers(game);
+    game->input = (InputState){0};
+    if (game->inputSource != NULL) game->inputSource->poll(game->inputSource, game, &game->input);
+    HandleInput(game);
+    t = RecordSystemTime(game, TIMING_INPUT, t);
+    UpdateProtesters(game);
+    t = RecordSystemTime(game, TIMING_PROTESTERS, t);
+    UpdateVehicles(game);
+    t = RecordSystemTime(game, TIMING_VEHICLES, t);
+    SolveCrowdConstraints(game);
+    PackCrowd(game);
+    t = RecordSystemTime(game, TIMING_CROWD, t);
+    UpdatePolice(game);
+    t = RecordSystemTime(game, TIMING_POLICE, t);
+    UpdateTearGas(game);
+    t = RecordSystemTime(game, TIMING_GAS, t);
+    UpdateHelicopter(game, dt);
+    t = RecordSystemTime(game, TIMING_HELICOPTER, t);
+
+    for (int i = 0; i < game->maxProjectiles; i++) {
+        Projectile *proj = &game->projectiles[i];
+        if (!proj->active) continue;
+        float moveStep = Vector2Length(proj->vel) * game->dt;
+        proj->pos = Vector2Add(proj->pos, Vector2Scale(proj->vel, game->dt));
+        proj->distance += moveStep;
+        proj->lifetime += game->dt;
+        if (proj->distance > proj->max_distance || proj->lifetime > 2.0f ||
+            proj->pos.x < 0 || proj->pos.x > game->worldWidth ||
+            proj->pos.y < 0 || proj->pos.y > WORLD_HEIGHT) {
+            if (proj->type == STONE) EmitParticles(game, PARTICLES_DUST, proj->pos, proj->vel);
+            proj->active = false;
+            continue;
+        }
+        // Helicopter fire comes from above; stones and bullets stop at vehicles
+        if (proj->type != HELICOPTER_BULLET &&
+            ProjectileBlocked(game, Vector2Subtract(proj->pos, Vector2Scale(proj->vel, game->dt)), proj->pos)) {
+            EmitParticles(game, PARTICLES_DUST, proj->pos, Vector2Negate(proj->vel));
+            proj->active = false;
+            continue;
+        }
+        if (proj->type == HELICOPTER_BULLET) {
+            for (int j = 0; j < game->maxProtesters; j++) {
+                if (PackedAlive(game->crowd[j]) &&
+                    Vector2Distance(proj->pos, PackedPosition(game->crowd[j], game->worldWidth)) < 8.0f) {
+                    PushGameEvent(game, EVENT_PROTESTER_HIT, CAUSE_HELICOPTER, j, proj->owner_id, proj->damage);
+                    proj->active = false;
+                    break;
+                }
+            }
+        } else if (proj->type == BULLET) {
+            for (int j = 0; j < game->maxProtesters; j++) {
+                if (PackedAlive(game->crowd[j]) &&
+                    Vector2Distance(proj->pos, PackedPosition(game->crowd[j], game->worldWidth)) < 8.0f) {
+                    PushGameEvent(game, EVENT_PROTESTER_HIT, CAUSE_BULLET, j, proj->owner_id, proj->damage);
+                    proj->active = false;
+                    break;
+                }
+            }
+        } else if (proj->type == STONE) {
+            for (int j = 0; j < game->maxPolice; j++) {
+                Police *pol = &game->police[j];
+                if (!pol->alive) continue;
+                float dist = Vector2Distance(proj->pos, pol->pos);
+                if (dist < 24.0f) {
+                    GameEvent *hit = PushGameEvent(game, EVENT_POLICE_HIT, CAUSE_STONE, j, proj->owner_id, proj->damage);
+                    if (hit != NULL) hit->impulse = Vector2Scale(proj->vel, 0.5f);
+                    EmitParticles(game, PARTICLES_DUST, proj->pos, Vector2Negate(proj->vel));
+                    proj->active = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    t = RecordSystemTime(game, TIMING_PROJECTILES, t);
+
+    ApplyGameEvents(game);
+    SpawnWaves(game, SPAWN_BUDGET); // after the reducer, so this tick's arrests free their slots
+    RecordSystemTime(game, TIMING_EVENTS, t);
+
+    if (CheckWinCondition(game))
+    {
+        game->menuState = MENU_WIN;
+    }
+    else if (CheckLoseCondition(game))
+    {
+        game->menuState = MENU_LOSE;
+    }
+}
+
+// Purely visual particles, kept apart from gameplay projectiles: the
+// simulation only calls EmitParticles, which is O(1) per particle and a
+// no-op when headless, and nothing here is read back by it.
+typedef struct
+{
+    int count;     // particles per emission
+    float spread;  // radians around the emission direction
+    float speedMin;
+    float speedMax;
+    float lifeMin; // seconds
+    float lifeMax;
+    float sizeMin;
+    float sizeMax;
+    float grow;    // size change per second
+    Color color;
+} ParticleEffectInfo;
+
+static const ParticleEffectInfo PARTICLE_EFFECT_INFO[PARTICLE_EFFECT_COUNT] = {
+    [PARTICLES_DUST] = {10, 2.0f * PI, 20.0f, 70.0f, 0.4f, 0.9f, 2.0f, 4.0f, 6.0f, {150, 130, 105, 200}},
+    [PARTICLES_MUZZLE] = {6, 0.35f, 90.0f, 180.0f, 0.06f, 0.14f, 2.0f, 4.0f, -12.0f, {255, 210, 90, 255}},
+    [PARTICLES_WASH] = {2, 2.0f, 60.0f, 140.0f, 0.5f, 1.0f, 3.0f, 6.0f, 10.0f, {200, 195, 180, 110}},
+    [PARTICLES_GAS] = {28, 2.0f * PI, 8.0f, 40.0f, 1.5f, 3.0f, 6.0f, 10.0f, 14.0f, {235, 235, 200, 120}},
+};
+
+// Four particles per SIMD step; GCC and Clang vector extensions lower this
+// to SSE/NEON without relying on the auto-vectorizer
+typedef float ParticleLane __attribute__((vector_size(16)));
+#define PARTICLE_LANE_WIDTH (int)(sizeof(ParticleLane) / sizeof(float))
+
+// Structure of arrays with a fixed capacity. Emitting appends and expiring
+// moves the last particle into the freed slot, so both are O(1) and live
+// particles stay packed at the front, where whole lanes are integrated at
+// once (a partial last lane just updates a few free slots).
+struct ParticleSystem
+{
+    Arena arena;
+    int capacity;
+    int count;
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *life;    // 1 at emission, expired at 0
+    float *fade;    // life lost per second
+    float *size;
+    float *grow;
+    Color *color;
+    uint64_t rng;   // separate from the game's, which effects must not consume
+};
+
+bool InitParticleSystem(ParticleSystem *particles, int capacity)
+{
+    memset(particles, 0, sizeof(ParticleSystem));
+    capacity -= capacity % PARTICLE_LANE_WIDTH;
+    if (!ArenaInit(&particles->arena, (sizeof(float) * 8 + sizeof(Color)) * capacity + 9 * ARENA_ALIGNMENT)) {
+        TraceLog(LOG_WARNING, "PARTICLES: Could not allocate %d particles", capacity);
+        return false;
+    }
+    particles->capacity = capacity;
+    // Arena allocations are 16-byte aligned, as the lanes require
+    float **arrays[] = {&particles->x, &particles->y, &particles->vx, &particles->vy,
+                        &particles->life, &particles->fade, &particles->size, &particles->grow};
+    for (int a = 0; a < 8; a++) *arrays[a] = ArenaAllocZeroed(&particles->arena, sizeof(float) * capacity);
+    particles->color = ArenaAlloc(&particles->arena, sizeof(Color) * capacity);
+    particles->rng = SeedRandom((uint64_t)time(NULL));
+    return true;
+}
+
+void UnloadParticleSystem(ParticleSystem *particles)
+{
+    ArenaFree(&particles->arena);
+    memset(particles, 0, sizeof(ParticleSystem));
+}
+
+static inline float ParticleRandom(ParticleSystem *particles, float min, float max)
+{
+    return min + (max - min) * NextRandom(&particles->rng, 0, 1023) / 1023.0f;
+}
+
+void EmitParticles(GameState *game, ParticleEffect effect, Vector2 pos, Vector2 dir)
+{
+    ParticleSystem *particles = game->particles;
+    if (particles == NULL) return;
+    const ParticleEffectInfo *info = &PARTICLE_EFFECT_INFO[effect];
+    float heading = atan2f(dir.y, dir.x);
+    for (int n = 0; n < info->count && particles->count < particles->capacity; n++) {
+        int i = particles->count++;
+        float angle = heading + ParticleRandom(particles, -0.5f, 0.5f) * info->spread;
+        float speed = ParticleRandom(particles, info->speedMin, info->speedMax);
+        particles->x[i] = pos.x;
+        particles->y[i] = pos.y;
+        particles->vx[i] = cosf(angle) * speed;
+        particles->vy[i] = sinf(angle) * speed;
+        particles->life[i] = 1.0f;
+        particles->fade[i] = 1.0f / ParticleRandom(particles, info->lifeMin, info->lifeMax);
+        particles->size[i] = ParticleRandom(particles, info->sizeMin, info->sizeMax);
+        particles->grow[i] = info->grow;
+        particles->color[i] = info->color;
+    }
+}
+
+void UpdateParticles(ParticleSystem *particles, float dt)
+{
+    int count = particles->count;
+    ParticleLane step = {dt, dt, dt, dt};
+    float decay = expf(-PARTICLE_DRAG * dt);
+    ParticleLane drag = {decay, decay, decay, decay};
+    ParticleLane *x = (ParticleLane *)particles->x;
+    ParticleLane *y = (ParticleLane *)particles->y;
+    ParticleLane *vx = (ParticleLane *)particles->vx;
+    ParticleLane *vy = (ParticleLane *)particles->vy;
+    ParticleLane *life = (ParticleLane *)particles->life;
+    ParticleLane *size = (ParticleLane *)particles->size;
+    const ParticleLane *fade = (const ParticleLane *)particles->fade;
+    const ParticleLane *grow = (const ParticleLane *)particles->grow;
+    int lanes = (count + PARTICLE_LANE_WIDTH - 1) / PARTICLE_LANE_WIDTH;
+    for (int l = 0; l < lanes; l++) {
+        x[l] += vx[l] * step;
+        y[l] += vy[l] * step;
+        vx[l] *= drag;
+        vy[l] *= drag;
+        life[l] -= fade[l] * step;
+        size[l] += grow[l] * step;
+    }
+
+    for (int i = 0; i < count;) {
+        if (particles->life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        count--;
+        particles->x[i] = particles->x[count];
+        particles->y[i] = particles->y[count];
+        particles->vx[i] = particles->vx[count];
+        particles->vy[i] = particles->vy[count];
+        particles->life[i] = particles->life[count];
+        particles->fade[i] = particles->fade[count];
+        particles->size[i] = particles->size[count];
+        particles->grow[i] = particles->grow[count];
+        particles->color[i] = particles->color[count];
+    }
+    particles->count = count;
+}
+
+// Every visible particle is one untextured quad in the current rlgl batch,
+// fading out with its life
+void DrawParticles(const ParticleSystem *particles, Rectangle view)
+{
+    if (particles->count == 0) return;
+    rlSetTexture(rlGetTextureIdDefault());
+    rlBegin(RL_QUADS);
+    for (int i = 0; i < particles->count; i++) {
+        float x = particles->x[i];
+        float y = particles->y[i];
+        float half = fmaxf(particles->size[i], 1.0f) * 0.5f; // shrinking effects may go below zero
+        if (x + half < view.x || x - half > view.x + view.width || y + half < view.y || y - half > view.y + view.height) {
+            continue;
+        }
+        Color color = particles->color[i];
+        rlCheckRenderBatchLimit(4);
+        rlColor4ub(color.r, color.g, color.b, (unsigned char)(color.a * particles->life[i]));
+        rlTexCoord2f(0.0f, 0.0f);
+        rlVertex2f(x - half, y - half);
+        rlTexCoord2f(0.0f, 1.0f);
+        rlVertex2f(x - half, y + half);
+        rlTexCoord2f(1.0f, 1.0f);
+        rlVertex2f(x + half, y + half);
+        rlTexCoord2f(1.0f, 0.0f);
+        rlVertex2f(x + half, y - half);
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
+
+void LoadLayerCache(LayerCache *layers, int width, int height)
+{
+    memset(layers, 0, sizeof(LayerCache));
+    for (int i = 0; i < BG_MAX_RESIDENT_TILES; i++) layers->background.tiles[i].index = -1;
+    layers->foreground = LoadRenderTexture(width, height);
+    layers->hud = LoadRenderTexture(width, HUD_LAYER_HEIGHT);
+    layers->world = LoadRenderTexture(width, height);
+    if (layers->world.id != 0) SetTextureFilter(layers->world.texture, TEXTURE_FILTER_POINT);
+    layers->worldScale = 1.0f;
+}
+
+void UnloadLayerCache(LayerCache *layers)
+{
+    for (int i = 0; i < BG_MAX_RESIDENT_TILES; i++) {
+        if (layers->background.tiles[i].texture.id != 0) UnloadTexture(layers->background.tiles[i].texture);
+    }
+    if (layers->foreground.id != 0) UnloadRenderTexture(layers->foreground);
+    if (layers->hud.id != 0) UnloadRenderTexture(layers->hud);
+    if (layers->world.id != 0) UnloadRenderTexture(layers->world);
+    if (layers->crowd.id != 0) UnloadTexture(layers->crowd);
+    free(layers->crowdAccum);
+    free(layers->crowdPixels);
+    memset(layers, 0, sizeof(LayerCache));
+}
+
+// Renders into a layer with premultiplied alpha, so translucent pixels keep
+// the right coverage when the layer is composited later.
+void BeginLayerRender(RenderTexture2D layer)
+{
+    BeginTextureMode(layer);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+}
+
+void EndLayerRender(void)
+{
+    EndBlendMode();
+    EndTextureMode();
+}
+
+void DrawLayer(RenderTexture2D layer, int blendMode)
+{
+    // Render textures are stored upside down
+    Rectangle src = {0, 0, (float)layer.texture.width, -(float)layer.texture.height};
+    BeginBlendMode(blendMode);
+    DrawTextureRec(layer.texture, src, (Vector2){0, 0}, WHITE);
+    EndBlendMode();
+}
+
+// Redirects world drawing into the scaled part of the world target. The
+// projection still spans the full screen, so cameras, culling and mouse
+// picking work in screen units as before.
+void BeginWorldRender(LayerCache *layers, int width, int height)
+{
+    BeginTextureMode(layers->world);
+    ClearBackground(RAYWHITE);
+    rlViewport(0, 0, (int)(width * layers->worldScale), (int)(height * layers->worldScale));
+    rlMatrixMode(RL_PROJECTION);
+    rlLoadIdentity();
+    rlOrtho(0, width, height, 0, 0.0, 1.0);
+    rlMatrixMode(RL_MODELVIEW);
+    rlLoadIdentity();
+    // Keep the target opaque under translucent gas so compositing is a copy
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+}
+
+// Upscales the world to the screen with point sampling
+void EndWorldRender(LayerCache *layers, int width, int height)
+{
+    EndBlendMode();
+    EndTextureMode();
+    Rectangle src = {0, 0, width * layers->worldScale, -height * layers->worldScale};
+    Rectangle dest = {0, 0, (float)width, (float)height};
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTexturePro(layers->world.texture, src, dest, (Vector2){0, 0}, 0.0f, WHITE);
+    EndBlendMode();
+}
+
+// Picks the world resolution from how long frames take to produce. Drops a
+// step as soon as the budget is nearly used, and only climbs back after a
+// sustained stretch of headroom, so the scale does not oscillate.
+void AdaptWorldScale(LayerCache *layers, double workTime)
+{
+    if (layers->world.id == 0) return;
+    layers->frameWork = (layers->frameWork == 0.0) ? workTime : layers->frameWork * 0.9 + workTime * 0.1;
+    if (layers->settleFrames > 0) {
+        layers->settleFrames--;
+        return;
+    }
+
+    if (layers->frameWork > FRAME_BUDGET * 0.9 && layers->worldScale > WORLD_SCALE_MIN) {
+        layers->worldScale = fmaxf(WORLD_SCALE_MIN, layers->worldScale - WORLD_SCALE_STEP);
+        layers->settleFrames = WORLD_SCALE_SETTLE;
+        layers->headroomFrames = 0;
+    } else if (layers->frameWork < FRAME_BUDGET * 0.6 && layers->worldScale < 1.0f) {
+        if (++layers->headroomFrames >= WORLD_SCALE_HEADROOM) {
+            layers->worldScale = fminf(1.0f, layers->worldScale + WORLD_SCALE_STEP);
+            layers->settleFrames = WORLD_SCALE_SETTLE;
+            layers->headroomFrames = 0;
+        }
+    } else {
+        layers->headroomFrames = 0;
+    }
+}
+
+// Drops sources that failed to load so tiles only cycle through real images
+void InitBackgroundStreamer(BackgroundStreamer *bg)
+{
+    int count = 0;
+    for (int i = 0; i < BG_SOURCE_COUNT; i++) {
+        if (bg->sources[i].data != NULL) bg->sources[count++] = bg->sources[i];
+    }
+    for (int i = count; i < BG_SOURCE_COUNT; i++) bg->sources[i] = (Image){0};
+    bg->sourceCount = count;
+}
+
+static Texture2D GenerateBackgroundTile(const BackgroundStreamer *bg, int index)
+{
+    const Image *source = &bg->sources[(index / BG_TILES_PER_SECTION) % bg->sourceCount];
+    float columnWidth = (float)source->width / BG_TILES_PER_SECTION;
+    Rectangle src = {(index % BG_TILES_PER_SECTION) * columnWidth, 0, columnWidth, (float)source->height};
+    Image column = ImageFromImage(*source, src);
+    ImageResizeNN(&column, BG_TILE_WIDTH, WORLD_HEIGHT);
+    Texture2D texture = LoadTextureFromImage(column);
+    UnloadImage(column);
+    if (texture.id != 0) SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+    return texture;
+}
+
+// Makes the columns around the view resident, uploading at most
+// BG_UPLOADS_PER_FRAME new tiles and recycling the least recently used ones.
+void UpdateBackgroundStreamer(BackgroundStreamer *bg, Rectangle view, float worldWidth)
+{
+    bg->frame++;
+    if (bg->sourceCount == 0) return;
+
+    int lastColumn = (int)ceilf(worldWidth / BG_TILE_WIDTH) - 1;
+    int first = (int)floorf(view.x / BG_TILE_WIDTH) - 1;
+    int last = (int)floorf((view.x + view.width) / BG_TILE_WIDTH) + 1;
+    if (first < 0) first = 0;
+    if (last > lastColumn) last = lastColumn;
+
+    int uploads = 0;
+    for (int index = first; index <= last; index++) {
+        BackgroundTile *slot = NULL;
+        BackgroundTile *victim = NULL;
+        for (int i = 0; i < BG_MAX_RESIDENT_TILES; i++) {
+            BackgroundTile *tile = &bg->tiles[i];
+            if (tile->index == index) {
+                slot = tile;
+                break;
+            }
+            if (tile->lastUsed != bg->frame && (victim == NULL || tile->index < 0 ||
+                (victim->index >= 0 && tile->lastUsed < victim->lastUsed))) {
+                victim = tile;
+            }
+        }
+        if (slot == NULL) {
+            if (victim == NULL || uploads >= BG_UPLOADS_PER_FRAME) continue;
+            if (victim->texture.id != 0) UnloadTexture(victim->texture);
+            victim->texture = GenerateBackgroundTile(bg, index);
+            victim->index = index;
+            uploads++;
+            slot = victim;
+        }
+        slot->lastUsed = bg->frame;
+    }
+}
+
+void DrawBackgroundTiles(const BackgroundStreamer *bg, Rectangle view, float worldWidth)
+{
+    int first = (int)floorf(view.x / BG_TILE_WIDTH);
+    int last = (int)floorf((view.x + view.width) / BG_TILE_WIDTH);
+    int lastColumn = (int)ceilf(worldWidth / BG_TILE_WIDTH) - 1;
+    if (first < 0) first = 0;
+    if (last > lastColumn) last = lastColumn;
+
+    for (int index = first; index <= last; index++) {
+        const BackgroundTile *tile = NULL;
+        for (int i = 0; i < BG_MAX_RESIDENT_TILES; i++) {
+            if (bg->tiles[i].index == index) {
+                tile = &bg->tiles[i];
+                break;
+            }
+        }
+        if (tile != NULL && tile->texture.id != 0) {
+            DrawTexture(tile->texture, index * BG_TILE_WIDTH, 0, WHITE);
+        } else {
+            DrawRectangle(index * BG_TILE_WIDTH, 0, BG_TILE_WIDTH, WORLD_HEIGHT, DARKGRAY);
+        }
+    }
+}
+
+Rectangle GetCameraView(Camera2D camera)
+{
+    Vector2 topLeft = GetScreenToWorld2D((Vector2){0, 0}, camera);
+    return (Rectangle){topLeft.x, topLeft.y, GetScreenWidth() / camera.zoom, GetScreenHeight() / camera.zoom};
+}
+
+// Arrow keys or middle-drag pan, the wheel zooms around the cursor. The
+// camera target is the world point at the top-left of the screen.
+void UpdateGameCamera(GameState *game, float dt)
+{
+    Camera2D *cam = &game->camera;
+    float screenW = (float)GetScreenWidth();
+    float screenH = (float)GetScreenHeight();
+    float minZoom = fmaxf(CAMERA_MIN_ZOOM, fminf(1.0f, screenW / game->worldWidth));
+
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0.0f) {
+        Vector2 mouse = GetMousePosition();
+        Vector2 anchor = GetScreenToWorld2D(mouse, *cam);
+        cam->zoom = Clamp(cam->zoom * (1.0f + 0.1f * wheel), minZoom, CAMERA_MAX_ZOOM);
+        cam->target = Vector2Subtract(anchor, Vector2Scale(mouse, 1.0f / cam->zoom));
+    }
+
+    float pan = CAMERA_PAN_SPEED * dt / cam->zoom;
+    if (IsKeyDown(KEY_LEFT)) cam->target.x -= pan;
+    if (IsKeyDown(KEY_RIGHT)) cam->target.x += pan;
+    if (IsKeyDown(KEY_UP)) cam->target.y -= pan;
+    if (IsKeyDown(KEY_DOWN)) cam->target.y += pan;
+    if (IsMouseButtonDown(MOUSE_MIDDLE_BUTTON)) {
+        cam->target = Vector2Subtract(cam->target, Vector2Scale(GetMouseDelta(), 1.0f / cam->zoom));
+    }
+
+    float viewW = screenW / cam->zoom;
+    float viewH = screenH / cam->zoom;
+    cam->target.x = (viewW >= game->worldWidth) ? (game->worldWidth - viewW) * 0.5f : Clamp(cam->target.x, 0, game->worldWidth - viewW);
+    cam->target.y = (viewH >= WORLD_HEIGHT) ? (WORLD_HEIGHT - viewH) * 0.5f : Clamp(cam->target.y, 0, WORLD_HEIGHT - viewH);
+}
+
+void DrawForegroundLayer(Texture2D *textures, int width, int height)
+{
+    if (textures[7].id != 0) {
+        DrawTexture(textures[7], 0, 0, WHITE);
+    }
+
+    if (textures[8].id != 0) {
+        Rectangle src = {0, 0, (float)textures[8].width, (float)textures[8].height};
+        Rectangle dest = {0, 0, (float)width, (float)height};
+        DrawTexturePro(textures[8], src, dest, (Vector2){0, 0}, 0.0f, WHITE);
+    }
+}
+
+// Composes the static layers; call once the textures they use are loaded
+void BuildStaticLayers(LayerCache *layers, Texture2D *textures)
+{
+    InitBackgroundStreamer(&layers->background);
+    if (layers->foreground.id == 0) return;
+    int width = layers->foreground.texture.width;
+    int height = layers->foreground.texture.height;
+
+    BeginLayerRender(layers->foreground);
+    DrawForegroundLayer(textures, width, height);
+    EndLayerRender();
+
+    layers->staticReady = true;
+}
+
+HudSnapshot CaptureHud(GameState *game)
+{
+    HudSnapshot hud = {0};
+    double now = game->time;
+    int timeLeft = (int)(GAME_DURATION - (now - game->gameStartTime));
+    hud.morale10 = (int)(game->globalMorale * 10.0f + 0.5f);
+    hud.timeLeft = (timeLeft > 0) ? timeLeft : 0;
+    hud.protesters = game->protesterCount;
+    hud.arrested = game->protesters_arrested;
+    hud.control10 = (int)(game->controlProgress * 1000.0f + 0.5f);
+    hud.controlTime10 = (game->controlStartTime > 0) ? (int)((now - game->controlStartTime) * 10.0) : 0;
+    hud.police = game->policeCount;
+    hud.surge10 = -1;
+    if (game->policeSurgeActive && game->policeSurgeEnd > now) {
+        hud.surge10 = (int)((game->policeSurgeEnd - now) * 10.0);
+    }
+    return hud;
+}
+
+void DrawHudContents(const HudSnapshot *hud, Font pixelFont, int screenWidth)
+{
+    float morale = hud->morale10 / 10.0f;
+    float controlPercentage = hud->control10 / 1000.0f;
+
+    DrawRectangle(20, 20, 300, 25, LIGHTGRAY);
+    Color moraleColor = (morale > 70) ? GREEN : (morale > 30) ? YELLOW : RED;
+    DrawRectangle(20, 20, (int)(3 * morale), 25, moraleColor);
+    DrawRectangleLines(20, 20, 300, 25, WHITE);
+    DrawTextEx(pixelFont, TextFormat("Movement Morale: %.1f%%", morale),
+               (Vector2){330, 22}, 20, 1, WHITE);
+
+    int minutes = hud->timeLeft / 60;
+    int seconds = hud->timeLeft % 60;
+
+    DrawTextEx(pixelFont, TextFormat("Time: %02d:%02d", minutes, seconds),
+               (Vector2){screenWidth - 200, 20}, 24, 1, WHITE);
+
+    DrawTextEx(pixelFont, TextFormat("Active Protesters: %d", hud->protesters),
+               (Vector2){20, 60}, 18, 1, WHITE);
+    DrawTextEx(pixelFont, TextFormat("Arrested: %d", hud->arrested),
+               (Vector2){20, 85}, 18, 1, WHITE);
+
+    DrawTextEx(pixelFont, "Territory Control:", (Vector2){screenWidth - 300, 60}, 18, 1, WHITE);
+    DrawRectangle(screenWidth - 300, 85, 200, 15, LIGHTGRAY);
+    DrawRectangle(screenWidth - 300, 85, (int)(200 * controlPercentage), 15, GREEN);
+    DrawRectangleLines(screenWidth - 300, 85, 200, 15, WHITE);
+
+    // Debug information
+    DrawTextEx(pixelFont, TextFormat("Control: %.1f%%", controlPercentage * 100), (Vector2){screenWidth - 300, 110}, 16, 1, WHITE);
+    DrawTextEx(pixelFont, TextFormat("Control Time: %.1f", hud->controlTime10 / 10.0f), (Vector2){screenWidth - 300, 130}, 16, 1, WHITE);
+    DrawTextEx(pixelFont, TextFormat("Police Left: %d", hud->police), (Vector2){screenWidth - 300, 150}, 16, 1, WHITE);
+
+    if (hud->surge10 >= 0) {
+        DrawTextEx(pixelFont, TextFormat("Police Surge: %.1f sec", hud->surge10 / 10.0f),
+                   (Vector2){screenWidth / 2 - 100, 20}, 24, 1, RED);
+    }
+}
+
+// Chooses the animation frame from the clock alone: no per-agent timers.
+// Must match the arithmetic in ANIM_VERTEX_SHADER.
+int AnimationFrame(float time, unsigned char phase, bool running)
+{
+    int frames = running ? 3 : 2;
+    float cycle = running ? 0.2f : 0.4f;
+    return (int)floorf(time / cycle + (phase / 128.0f) * frames) % frames;
+}
+
+// The sprite's tint alpha carries the run flag (bit 7) and the agent's
+// phase (bits 0-6); the vertex shader decodes them, offsets the texture
+// coordinates to the current frame and restores an opaque tint.
+static const char *ANIM_VERTEX_SHADER =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec2 vertexTexCoord;\n"
+    "in vec4 vertexColor;\n"
+    "uniform mat4 mvp;\n"
+    "uniform float time;\n"
+    "uniform vec2 cellSize;\n"
+    "out vec2 fragTexCoord;\n"
+    "out vec4 fragColor;\n"
+    "void main()\n"
+    "{\n"
+    "    float packed = floor(vertexColor.a * 255.0 + 0.5);\n"
+    "    float running = step(128.0, packed);\n"
+    "    float phase = (packed - running * 128.0) / 128.0;\n"
+    "    float frames = mix(2.0, 3.0, running);\n"
+    "    float cycle = mix(0.4, 0.2, running);\n"
+    "    float frame = mod(floor(time / cycle + phase * frames), frames);\n"
+    "    fragTexCoord = vertexTexCoord + vec2(frame * cellSize.x, 0.0);\n"
+    "    fragColor = vec4(vertexColor.rgb, 1.0);\n"
+    "    gl_Position = mvp * vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+// Average color of an image's opaque pixels, for tinting the crowd impostor
+Color MeanOpaqueColor(Image image)
+{
+    Color mean = {160, 150, 140, 255};
+    if (image.data == NULL) return mean;
+    Color *pixels = LoadImageColors(image);
+    if (pixels == NULL) return mean;
+    unsigned long sum[3] = {0, 0, 0};
+    unsigned long count = 0;
+    for (int i = 0; i < image.width * image.height; i++) {
+        if (pixels[i].a < 128) continue;
+        sum[0] += pixels[i].r;
+        sum[1] += pixels[i].g;
+        sum[2] += pixels[i].b;
+        count++;
+    }
+    UnloadImageColors(pixels);
+    if (count > 0) mean = (Color){(unsigned char)(sum[0] / count), (unsigned char)(sum[1] / count), (unsigned char)(sum[2] / count), 255};
+    return mean;
+}
+
+// Packs both factions' frames into the shared atlas; call once loading is
+// done. The source images stay owned by the asset loader.
+void BuildSpriteAtlas(GameAssets *assets)
+{
+    assets->crowdColor = MeanOpaqueColor(assets->protester.sprites[0]);
+    SpriteSet *sets[2] = {&assets->protester, &assets->police};
+    int cellWidth = 0;
+    int cellHeight = 0;
+    for (int f = 0; f < 2; f++) {
+        for (int j = 0; j < 2; j++) {
+            cellWidth = (sets[f]->sprites[j].width > cellWidth) ? sets[f]->sprites[j].width : cellWidth;
+            cellHeight = (sets[f]->sprites[j].height > cellHeight) ? sets[f]->sprites[j].height : cellHeight;
+        }
+        for (int j = 0; j < 3; j++) {
+            cellWidth = (sets[f]->run_sprites[j].width > cellWidth) ? sets[f]->run_sprites[j].width : cellWidth;
+            cellHeight = (sets[f]->run_sprites[j].height > cellHeight) ? sets[f]->run_sprites[j].height : cellHeight;
+        }
+    }
+    if (cellWidth == 0 || cellHeight == 0) return;
+
+    Image atlas = GenImageColor(cellWidth * 3, cellHeight * 4, BLANK);
+    for (int f = 0; f < 2; f++) {
+        for (int row = 0; row < 2; row++) {
+            int count = (row == 0) ? 2 : 3;
+            for (int j = 0; j < count; j++) {
+                Image frame = (row == 0) ? sets[f]->sprites[j] : sets[f]->run_sprites[j];
+                if (frame.data == NULL) continue;
+                Rectangle src = {0, 0, (float)frame.width, (float)frame.height};
+                Rectangle dst = {(float)(j * cellWidth + (cellWidth - frame.width) / 2),
+                                 (float)((f * 2 + row) * cellHeight + (cellHeight - frame.height) / 2),
+                                 (float)frame.width, (float)frame.height};
+                ImageDraw(&atlas, frame, src, dst, WHITE);
+            }
+        }
+    }
+    assets->atlas = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+    if (assets->atlas.id == 0) return;
+    SetTextureFilter(assets->atlas, TEXTURE_FILTER_POINT);
+    assets->cellWidth = cellWidth;
+    assets->cellHeight = cellHeight;
+
+    assets->animShader = LoadShaderFromMemory(ANIM_VERTEX_SHADER, NULL);
+    if (assets->animShader.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "ASSETS: Animation shader unavailable, selecting frames on the CPU");
+        assets->animShader = (Shader){0};
+        return;
+    }
+    assets->timeLoc = GetShaderLocation(assets->animShader, "time");
+    assets->cellSizeLoc = GetShaderLocation(assets->animShader, "cellSize");
+    Vector2 cellSize = {(float)cellWidth / assets->atlas.width, (float)cellHeight / assets->atlas.height};
+    SetShaderValue(assets->animShader, assets->cellSizeLoc, &cellSize, SHADER_UNIFORM_VEC2);
+}
+
+// Draws one agent from the atlas. With the shader the frame is chosen on
+// the GPU from the tint; otherwise the source rectangle is offset here.
+// Faded sprites (alpha below 255) always take the CPU path, so they must be
+// drawn outside the shader batch.
+void DrawAgentSprite(const GameAssets *assets, Faction faction, bool running, unsigned char phase,
+                     Vector2 center, Color tint, float time, unsigned char alpha)
+{
+    int row = (int)faction * 2 + (running ? 1 : 0);
+    Rectangle src = {0, (float)(row * assets->cellHeight), (float)assets->cellWidth, (float)assets->cellHeight};
+    Rectangle dest = {center.x - assets->cellWidth / 2, center.y - assets->cellHeight / 2,
+                      (float)assets->cellWidth, (float)assets->cellHeight};
+    if (assets->animShader.id != 0 && alpha == 255) {
+        tint.a = (unsigned char)((running ? 128 : 0) | (phase & 127));
+    } else {
+        src.x = (float)(AnimationFrame(time, phase, running) * assets->cellWidth);
+        tint.a = alpha;
+    }
+    DrawTexturePro(assets->atlas, src, dest, (Vector2){0, 0}, 0.0f, tint);
+}
+
+Color ProtesterTint(ProtesterState state)
+{
+    switch (state) {
+        case CHANT: return SKYBLUE;
+        case RIOT: return ORANGE;
+        case FLEE: return PINK;
+        case IDLE:
+        default: return WHITE;
+    }
+}
+
+Color PoliceTint(PoliceState state)
+{
+    if (state == INTERVENE || state == DEPLOY) {
+        return RED;
+    } else if (state == PATROL) {
+        return LIGHTGRAY;
+    }
+    return WHITE;
+}
+
+// Crowd impostor: protesters far from the cursor are splatted into a
+// coarse color-and-coverage texture over the field, drawn as one bilinear
+// quad. Only the columns in view are cleared, resolved and uploaded, so its
+// cost follows the view size rather than the crowd size.
+static bool LoadCrowdImpostor(LayerCache *layers, float worldWidth)
+{
+    layers->crowdColumns = (int)ceilf(worldWidth / IMPOSTOR_CELL);
+    layers->crowdRows = (FIELD_BOTTOM - IMPOSTOR_TOP) / IMPOSTOR_CELL + IMPOSTOR_BODY_CELLS;
+    int texels = layers->crowdColumns * layers->crowdRows;
+    layers->crowdAccum = calloc((size_t)texels * 4, sizeof(uint32_t));
+    layers->crowdPixels = malloc(sizeof(Color) * texels);
+    Image blank = GenImageColor(layers->crowdColumns, layers->crowdRows, BLANK);
+    layers->crowd = LoadTextureFromImage(blank);
+    UnloadImage(blank);
+    if (layers->crowd.id == 0 || layers->crowdAccum == NULL || layers->crowdPixels == NULL) {
+        TraceLog(LOG_WARNING, "RENDER: Crowd impostor unavailable, drawing every sprite");
+        return false;
+    }
+    SetTextureFilter(layers->crowd, TEXTURE_FILTER_BILINEAR);
+    return true;
+}
+
+static void ClearCrowdImpostor(LayerCache *layers, int firstColumn, int lastColumn)
+{
+    for (int row = 0; row < layers->crowdRows; row++) {
+        uint32_t *accum = &layers->crowdAccum[(row * layers->crowdColumns + firstColumn) * 4];
+        memset(accum, 0, sizeof(uint32_t) * 4 * (lastColumn - firstColumn + 1));
+    }
+}
+
+// weight is 0..256; the body covers IMPOSTOR_BODY_CELLS texels of one column
+static void SplatProtester(LayerCache *layers, Vector2 pos, Color color, uint32_t weight)
+{
+    int column = (int)(pos.x / IMPOSTOR_CELL);
+    int top = (int)((pos.y - IMPOSTOR_TOP) / IMPOSTOR_CELL) - IMPOSTOR_BODY_CELLS / 2;
+    if (column < 0 || column >= layers->crowdColumns) return;
+    for (int row = top; row < top + IMPOSTOR_BODY_CELLS; row++) {
+        if (row < 0 || row >= layers->crowdRows) continue;
+        uint32_t *accum = &layers->crowdAccum[(row * layers->crowdColumns + column) * 4];
+        accum[0] += weight;
+        accum[1] += color.r * weight;
+        accum[2] += color.g * weight;
+        accum[3] += color.b * weight;
+    }
+}
+
+// Resolves the columns to premultiplied texels, uploads them and draws them
+static void DrawCrowdImpostor(LayerCache *layers, int firstColumn, int lastColumn)
+{
+    int width = lastColumn - firstColumn + 1;
+    for (int row = 0; row < layers->crowdRows; row++) {
+        const uint32_t *accum = &layers->crowdAccum[(row * layers->crowdColumns + firstColumn) * 4];
+        Color *out = &layers->crowdPixels[row * width];
+        for (int x = 0; x < width; x++, accum += 4) {
+            if (accum[0] == 0) {
+                out[x] = BLANK;
+                continue;
+            }
+            // One whole protester already reads as mostly opaque
+            uint32_t alpha = (accum[0] * 200 / 256 < 255) ? accum[0] * 200 / 256 : 255;
+            out[x] = (Color){(unsigned char)(accum[1] / accum[0] * alpha / 255),
+                             (unsigned char)(accum[2] / accum[0] * alpha / 255),
+                             (unsigned char)(accum[3] / accum[0] * alpha / 255), (unsigned char)alpha};
+        }
+    }
+    Rectangle columns = {(float)firstColumn, 0, (float)width, (float)layers->crowdRows};
+    UpdateTextureRec(layers->crowd, columns, layers->crowdPixels);
+    Rectangle dest = {firstColumn * (float)IMPOSTOR_CELL, (float)IMPOSTOR_TOP,
+                      width * (float)IMPOSTOR_CELL, layers->crowdRows * (float)IMPOSTOR_CELL};
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTexturePro(layers->crowd, columns, dest, (Vector2){0, 0}, 0.0f, WHITE);
+    EndBlendMode();
+}
+
+void DrawGame(GameState *game, const GameAssets *assets, LayerCache *layers, Font pixelFont, Texture2D *textures)
+{
+    int screenWidth = GetScreenWidth();
+    int screenHeight = GetScreenHeight();
+    DrawEntity *drawList = ArenaAlloc(&game->frameArena, sizeof(DrawEntity) * (game->maxProtesters + game->maxPolice));
+    int drawCount = 0;
+    if (drawList == NULL) return;
+
+    // Everything outside the camera view is rejected before any draw work
+    Rectangle view = GetCameraView(game->camera);
+    Rectangle cull = {view.x - CULL_MARGIN, view.y - CULL_MARGIN, view.width + 2 * CULL_MARGIN, view.height + 2 * CULL_MARGIN};
+
+    // Dense or zoomed-out crowds become an impostor, except for selected
+    // protesters and those near the cursor. The switch uses last frame's
+    // visible count, with hysteresis so it does not flicker.
+    bool impostor = (layers->crowdImpostor || game->camera.zoom <= IMPOSTOR_ZOOM) && assets->atlas.id != 0 &&
+                    (layers->crowd.id != 0 || LoadCrowdImpostor(layers, game->worldWidth));
+    Vector2 cursor = GetScreenToWorld2D(GetMousePosition(), game->camera);
+    float focusInner = IMPOSTOR_FOCUS_INNER / game->camera.zoom;
+    float focusOuter = IMPOSTOR_FOCUS_OUTER / game->camera.zoom;
+    int firstColumn = 0;
+    int lastColumn = 0;
+    if (impostor) {
+        firstColumn = (int)Clamp(cull.x / IMPOSTOR_CELL, 0, layers->crowdColumns - 1);
+        lastColumn = (int)Clamp((cull.x + cull.width) / IMPOSTOR_CELL, 0, layers->crowdColumns - 1);
+        ClearCrowdImpostor(layers, firstColumn, lastColumn);
+    }
+
+    int visible = 0;
+    for (int i = 0; i < game->maxProtesters; i++) {
+        if (!PackedAlive(game->crowd[i])) continue;
+        Vector2 pos = PackedPosition(game->crowd[i], game->worldWidth);
+        if (!CheckCollisionPointRec(pos, cull)) continue;
+        visible++;
+        float alpha = 1.0f;
+        if (impostor && !IsSelected(game, i)) {
+            float dist = Vector2Distance(pos, cursor);
+            alpha = Clamp((focusOuter - dist) / (focusOuter - focusInner), 0.0f, 1.0f);
+            if (alpha < 1.0f) {
+                Color tint = ProtesterTint(PackedState(game->crowd[i]));
+                Color color = {(unsigned char)(assets->crowdColor.r * tint.r / 255), (unsigned char)(assets->crowdColor.g * tint.g / 255),
+                               (unsigned char)(assets->crowdColor.b * tint.b / 255), 255};
+                SplatProtester(layers, pos, color, (uint32_t)((1.0f - alpha) * 256.0f));
+            }
+            if (alpha <= 0.0f) continue;
+        }
+        drawList[drawCount].y = pos.y;
+        drawList[drawCount].type = 1;
+        drawList[drawCount].index = i;
+        drawList[drawCount].alpha = (unsigned char)(alpha * 255.0f);
+        drawCount++;
+    }
+    layers->crowdImpostor = layers->crowdImpostor ? (visible >= IMPOSTOR_COUNT_OFF) : (visible >= IMPOSTOR_COUNT_ON);
+
+    for (int i = 0; i < game->maxPolice; i++) {
+        if (game->police[i].alive && CheckCollisionPointRec(game->police[i].pos, cull)) {
+            drawList[drawCount].y = game->police[i].pos.y;
+            drawList[drawCount].type = 2;
+            drawList[drawCount].index = i;
+            drawList[drawCount].alpha = 255;
+            drawCount++;
+        }
+    }
+
+    UpdateBackgroundStreamer(&layers->background, view, game->worldWidth);
+
+    // At full scale the world goes straight to the backbuffer
+    bool scaled = (layers->world.id != 0 && layers->worldScale < 1.0f);
+    if (scaled) BeginWorldRender(layers, screenWidth, screenHeight);
+
+    BeginMode2D(game->camera);
+    DrawBackgroundTiles(&layers->background, view, game->worldWidth);
+
+    if (CheckCollisionPointRec(game->helicopter.pos, cull)) {
+        DrawHelicopter(game, textures[9]);
+    }
+
+    if (impostor) {
+        DrawCrowdImpostor(layers, firstColumn, lastColumn);
+        if (scaled) BeginBlendMode(BLEND_CUSTOM_SEPARATE); // the impostor's blend mode replaced the world target's
+    }
+    DrawVehicles(game, textures[2], textures[3], cull);
+
+    for (int i = 1; i < drawCount; i++) {
+        DrawEntity key = drawList[i];
+        int j = i - 1;
+        while (j >= 0 && drawList[j].y > key.y) {
+            drawList[j + 1] = drawList[j];
+            j = j - 1;
+        }
+        drawList[j + 1] = key;
+    }
+
+    // Sprites first, in one batch on the atlas; overlays in a second pass so
+    // they do not interrupt it.
+    if (assets->atlas.id != 0) {
+        if (assets->animShader.id != 0) {
+            BeginShaderMode(assets->animShader);
+            SetShaderValue(assets->animShader, assets->timeLoc, &game->animTime, SHADER_UNIFORM_FLOAT);
+        }
+        for (int pass = 0; pass < 2; pass++) {
+            // Sprites fading into the impostor come after the shader batch
+            if (pass == 1 && assets->animShader.id != 0) EndShaderMode();
+            for (int i = 0; i < drawCount; i++) {
+                DrawEntity entity = drawList[i];
+                if ((entity.alpha == 255) != (pass == 0)) continue;
+                if (entity.type == 1) {
+                    Protester *p = &game->protesters[entity.index];
+                    DrawAgentSprite(assets, FACTION_PROTESTER, p->state == RIOT || p->state == FLEE, p->anim_phase,
+                                    p->pos, ProtesterTint(p->state), game->animTime, entity.alpha);
+                } else {
+                    Police *p = &game->police[entity.index];
+                    DrawAgentSprite(assets, FACTION_POLICE, p->state == INTERVENE || p->state == DEPLOY, p->anim_phase,
+                                    p->pos, PoliceTint(p->state), game->animTime, entity.alpha);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < drawCount; i++) {
+        DrawEntity entity = drawList[i];
+        switch (entity.type) {
+        case 1: {
+            Protester *p = &game->protesters[entity.index];
+            if (assets->atlas.id == 0) {
+                DrawCircleV(p->pos, 8, ProtesterTint(p->state));
+            }
+            if (IsSelected(game, entity.index)) {
+                DrawRectangleLines((int)(p->pos.x - 19), (int)(p->pos.y - 34), 39, 69, BLUE);
+                DrawCircleLines((int)p->pos.x, (int)p->pos.y, 18, BLUE);
+            }
+            if (p->state == CHANT && entity.alpha == 255) {
+                const char *slogans[] = {
+                    "Tumi ke ami ke",
+                    "Quota na medha",
+                    "Medha!!",
+                    "Odhikar chai",
+                    "Nyay chai"};
+                int sloganIdx = entity.index % 5;
+                Vector2 bubblePos = {p->pos.x - 30, p->pos.y - 35};
+                int textWidth = MeasureText(slogans[sloganIdx], 12);
+                DrawRectangle((int)bubblePos.x, (int)bubblePos.y, textWidth + 10, 20, WHITE);
+                DrawRectangleLines((int)bubblePos.x, (int)bubblePos.y, textWidth + 10, 20, DARKBLUE);
+                DrawTextEx(pixelFont, slogans[sloganIdx], (Vector2){bubblePos.x + 5, bubblePos.y + 4}, 12, 1, DARKBLUE);
+            }
+            if (IsSelected(game, entity.index)) {
+                DrawRectangle((int)(p->pos.x - 8), (int)(p->pos.y + 10), 16, 3, RED);
+                DrawRectangle((int)(p->pos.x - 8), (int)(p->pos.y + 10), (int)(16 * p->morale / 100.0f), 3, GREEN);
+            }
+            break;
+        }
+        case 2: {
+            Police *p = &game->police[entity.index];
+            if (assets->atlas.id == 0) {
+                DrawCircleV(p->pos, 8, PoliceTint(p->state));
+            }
+            if (p->state == DEPLOY) {
+                DrawCircleLines((int)p->pos.x, (int)p->pos.y, 20, YELLOW);
+            } else if (p->state == INTERVENE) {
+                DrawCircleLines((int)p->pos.x, (int)p->pos.y, 15, RED);
+            }
+            break;
+        }
+        }
+    }
+
+    for (int g = 0; g < game->maxGas; g++) {
+        if (game->gas[g].active && CheckCollisionCircleRec(game->gas[g].pos, game->gas[g].radius, view)) {
+            DrawCircleV(game->gas[g].pos, game->gas[g].radius, Fade(YELLOW, 0.5f));
+        }
+    }
+
+    for (int i = 0; i < game->maxProjectiles; i++) {
+        Projectile *proj = &game->projectiles[i];
+        if (proj->active && CheckCollisionPointRec(proj->pos, view)) {
+            if (proj->type == STONE) {
+                DrawCircleV(proj->pos, 3, GRAY);
+            } else if (proj->type == BULLET) {
+                DrawCircleV(proj->pos, 2, RED);
+            } else if (proj->type == HELICOPTER_BULLET) {
+                DrawCircleV(proj->pos, 3, ORANGE);
+            }
+        }
+    }
+
+    if (game->particles != NULL) DrawParticles(game->particles, view);
+
+    if (game->isSelecting) {
+        float minX = fminf(game->selectStart.x, game->selectEnd.x);
+        float maxX = fmaxf(game->selectStart.x, game->selectEnd.x);
+        float minY = fminf(game->selectStart.y, game->selectEnd.y);
+        float maxY = fmaxf(game->selectStart.y, game->selectEnd.y);
+        DrawRectangleLinesEx((Rectangle){minX, minY, maxX - minX, maxY - minY}, 1.0f / game->camera.zoom, BLUE);
+    }
+    EndMode2D();
+
+    if (layers->staticReady) {
+        DrawLayer(layers->foreground, BLEND_ALPHA_PREMULTIPLY);
+    } else {
+        DrawForegroundLayer(textures, screenWidth, screenHeight);
+    }
+
+    if (scaled) EndWorldRender(layers, screenWidth, screenHeight);
+
+    // The HUD always renders at native resolution
+    DrawUI(game, layers, pixelFont);
+}
+
+void DrawUI(GameState *game, LayerCache *layers, Font pixelFont)
+{
+    const int screenWidth = GetScreenWidth();
+
+    DrawRectangle(0, 0, screenWidth, 110, Fade(BLACK, 0.6f));
+
+    // The panel contents are only re-rasterized when a displayed value changes
+    HudSnapshot hud = CaptureHud(game);
+    if (layers->hud.id == 0) {
+        DrawHudContents(&hud, pixelFont, screenWidth);
+    } else {
+        if (!layers->hudValid || memcmp(&hud, &layers->hudShown, sizeof(HudSnapshot)) != 0) {
+            BeginLayerRender(layers->hud);
+            DrawHudContents(&hud, pixelFont, screenWidth);
+            EndLayerRender();
+            layers->hudShown = hud;
+            layers->hudValid = true;
+        }
+        DrawLayer(layers->hud, BLEND_ALPHA_PREMULTIPLY);
+    }
+
+    double now = game->time;
+    for (int i = 0; i < EVENT_FEED_SIZE; i++) {
+        if (game->stats.feed[i] == NULL) break;
+        float age = (float)(now - game->stats.feedTime[i]);
+        if (age > 4.0f) break;
+        DrawTextEx(pixelFont, game->stats.feed[i], (Vector2){20, 120 + 20 * i}, 16, 1, Fade(WHITE, 1.0f - age / 4.0f));
+    }
+}
+
+// Read-only view of assets.pak. Payloads are used in place from the
+// mapping, so the archive must outlive everything loaded from it.
+typedef struct
+{
+    MappedFile file;
+    const PackEntry *entries;
+    int entryCount;
+} AssetArchive;
+
+// An entry must lie inside the file, and an image's payload must hold
+// exactly its pixels, since it is uploaded straight from the mapping
+static bool PackEntryValid(const PackEntry *entry, size_t fileSize)
+{
+    if (entry->offset > fileSize || entry->size > fileSize - entry->offset) return false;
+    if (entry->kind != PACK_RGBA8) return true;
+    return entry->width <= INT32_MAX && entry->height <= INT32_MAX &&
+           entry->size % 4 == 0 && (uint64_t)entry->width * entry->height == entry->size / 4;
+}
+
+bool OpenAssetArchive(AssetArchive *archive, const char *path)
+{
+    memset(archive, 0, sizeof(AssetArchive));
+    if (!PlatformMapFile(path, &archive->file)) return false;
+
+    const PackHeader *header = (const PackHeader *)archive->file.data;
+    bool valid = archive->file.size >= sizeof(PackHeader) &&
+                 header->magic == PACK_MAGIC && header->version == PACK_VERSION &&
+                 sizeof(PackHeader) + (size_t)header->entryCount * sizeof(PackEntry) <= archive->file.size;
+    if (valid) {
+        archive->entries = (const PackEntry *)(archive->file.data + sizeof(PackHeader));
+        archive->entryCount = (int)header->entryCount;
+        for (int i = 0; i < archive->entryCount && valid; i++) {
+            valid = PackEntryValid(&archive->entries[i], archive->file.size);
+        }
+    }
+    if (!valid) {
+        TraceLog(LOG_WARNING, "ASSETS: %s is not a valid asset archive", path);
+        PlatformUnmapFile(&archive->file);
+        memset(archive, 0, sizeof(AssetArchive));
+        return false;
+    }
+    TraceLog(LOG_INFO, "ASSETS: Mapped %s (%i entries)", path, archive->entryCount);
+    return true;
+}
+
+void CloseAssetArchive(AssetArchive *archive)
+{
+    PlatformUnmapFile(&archive->file);
+    memset(archive, 0, sizeof(AssetArchive));
+}
+
+const PackEntry *FindPackEntry(const AssetArchive *archive, const char *name)
+{
+    for (int i = 0; i < archive->entryCount; i++) {
+        if (strncmp(archive->entries[i].name, name, PACK_NAME_LENGTH) == 0) return &archive->entries[i];
+    }
+    return NULL;
+}
+
+typedef enum
+{
+    ASSET_TEXTURE,
+    ASSET_IMAGE, // CPU-side only; the loader keeps ownership of the pixels
+    ASSET_MUSIC,
+    ASSET_FONT
+} AssetKind;
+
+typedef enum
+{
+    ASSET_PENDING, // waiting for the decode thread
+    ASSET_DECODED, // CPU-side data ready, waiting for upload
+    ASSET_READY,   // uploaded / handed over on the main thread
+    ASSET_FAILED
+} AssetStatus;
+
+typedef struct
+{
+    const char *path;
+    AssetKind kind;
+    void *target;        // Texture2D, Image, Music or Font to fill in on upload
+    Image image;         // decoded pixels (textures)
+    unsigned char *data; // raw file bytes (music, font)
+    int dataSize;
+    bool borrowed;       // image/data point into the archive mapping
+    _Atomic int status;
+} AssetJob;
+
+// Decodes files on a background thread; the main thread only performs the
+// GPU/audio-device work in PumpAssetLoader, a few milliseconds per frame.
+typedef struct
+{
+    const AssetArchive *archive; // optional; loose files are used otherwise
+    AssetJob jobs[MAX_ASSET_JOBS];
+    int jobCount;
+    int finished;
+    pthread_t worker;
+    bool workerStarted;
+    atomic_bool cancel;
+} AssetLoader;
+
+void QueueAsset(AssetLoader *loader, const char *path, AssetKind kind, void *target)
+{
+    if (loader->workerStarted || loader->jobCount >= MAX_ASSET_JOBS) {
+        TraceLog(LOG_WARNING, "ASSETS: Cannot queue %s", path);
+        return;
+    }
+    AssetJob *job = &loader->jobs[loader->jobCount++];
+    job->path = path;
+    job->kind = kind;
+    job->target = target;
+    atomic_init(&job->status, ASSET_PENDING);
+}
+
+static void *AssetDecodeThread(void *arg)
+{
+    AssetLoader *loader = (AssetLoader *)arg;
+    for (int i = 0; i < loader->jobCount && !atomic_load(&loader->cancel); i++) {
+        AssetJob *job = &loader->jobs[i];
+        bool ok = false;
+        const PackEntry *entry = (loader->archive != NULL) ? FindPackEntry(loader->archive, job->path) : NULL;
+        bool wantsImage = (job->kind == ASSET_TEXTURE || job->kind == ASSET_IMAGE);
+        if (entry != NULL && (entry->kind == PACK_RGBA8) == wantsImage) {
+            unsigned char *payload = (unsigned char *)loader->archive->file.data + entry->offset;
+            if (wantsImage) {
+                job->image = (Image){payload, (int)entry->width, (int)entry->height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+            } else {
+                job->data = payload;
+                job->dataSize = (int)entry->size;
+            }
+            job->borrowed = true;
+            ok = true;
+        } else if (wantsImage) {
+            job->image = LoadImage(job->path);
+            ok = (job->image.data != NULL);
+        } else {
+            job->data = LoadFileData(job->path, &job->dataSize);
+            ok = (job->data != NULL);
+        }
+        atomic_store(&job->status, ok ? ASSET_DECODED : ASSET_FAILED);
+    }
+    return NULL;
+}
+
+void StartAssetLoader(AssetLoader *loader)
+{
+    atomic_init(&loader->cancel, false);
+    loader->workerStarted = (pthread_create(&loader->worker, NULL, AssetDecodeThread, loader) == 0);
+    if (!loader->workerStarted) {
+        TraceLog(LOG_WARNING, "ASSETS: Decode thread unavailable, loading synchronously");
+        AssetDecodeThread(loader);
+    }
+}
+
+static void UploadAsset(AssetJob *job)
+{
+    switch (job->kind) {
+    case ASSET_TEXTURE: {
+        Texture2D *texture = (Texture2D *)job->target;
+        *texture = LoadTextureFromImage(job->image);
+        if (texture->id != 0) SetTextureFilter(*texture, TEXTURE_FILTER_POINT);
+        if (!job->borrowed) UnloadImage(job->image);
+        job->image = (Image){0};
+        break;
+    }
+    case ASSET_IMAGE:
+        *(Image *)job->target = job->image;
+        break;
+    case ASSET_MUSIC:
+        // The stream decodes from job->data while playing; it is freed in
+        // UnloadAssetLoader (or unmapped with the archive) after the music
+        // is unloaded.
+        *(Music *)job->target = LoadMusicStreamFromMemory(GetFileExtension(job->path), job->data, job->dataSize);
+        break;
+    case ASSET_FONT: {
+        Font font = LoadFontFromMemory(GetFileExtension(job->path), job->data, job->dataSize, 32, NULL, 0);
+        if (font.texture.id != 0) *(Font *)job->target = font;
+        if (!job->borrowed) UnloadFileData(job->data);
+        job->data = NULL;
+        break;
+    }
+    }
+}
+
+// Uploads decoded assets until the time budget is spent. Returns true once
+// every queued asset is either ready or failed.
+bool PumpAssetLoader(AssetLoader *loader, double budget)
+{
+    double start = GetTime();
+    for (int i = 0; i < loader->jobCount; i++) {
+        AssetJob *job = &loader->jobs[i];
+        int status = atomic_load(&job->status);
+        if (status == ASSET_FAILED) {
+            TraceLog(LOG_WARNING, "ASSETS: Failed to load %s", job->path);
+            atomic_store(&job->status, ASSET_READY);
+            job->target = NULL;
+            loader->finished++;
+        } else if (status == ASSET_DECODED) {
+            UploadAsset(job);
+            atomic_store(&job->status, ASSET_READY);
+            loader->finished++;
+            if (GetTime() - start > budget) break;
+        }
+    }
+    return loader->finished == loader->jobCount;
+}
+
+float AssetLoaderProgress(const AssetLoader *loader)
+{
+    return (loader->jobCount > 0) ? (float)loader->finished / loader->jobCount : 1.0f;
+}
+
+void UnloadAssetLoader(AssetLoader *loader)
+{
+    if (loader->workerStarted) {
+        atomic_store(&loader->cancel, true);
+        pthread_join(loader->worker, NULL);
+        loader->workerStarted = false;
+    }
+    for (int i = 0; i < loader->jobCount; i++) {
+        AssetJob *job = &loader->jobs[i];
+        if (job->borrowed) continue;
+        if (job->image.data != NULL) UnloadImage(job->image);
+        if (job->data != NULL) UnloadFileData(job->data);
+    }
+    loader->jobCount = 0;
+}
+
+void QueueSpriteSet(AssetLoader *loader, SpriteSet *set, const char *idleFiles[2], const char *runFiles[3])
+{
+    for (int j = 0; j < 2; j++) QueueAsset(loader, idleFiles[j], ASSET_IMAGE, &set->sprites[j]);
+    for (int j = 0; j < 3; j++) QueueAsset(loader, runFiles[j], ASSET_IMAGE, &set->run_sprites[j]);
+}
+
+// Sprites are shared by all agents and loaded once, so a restart never
+// touches the GPU.
+void QueueGameAssets(AssetLoader *loader, GameAssets *assets)
+{
+    static const char *protesterIdle[2] = {"protester.png", "protester2.png"};
+    static const char *protesterRun[3] = {"protestersRun1.png", "protestersRun2.png", "protestersRun3.png"};
+    static const char *policeIdle[2] = {"police.png", "police2.png"};
+    static const char *policeRun[3] = {"policeRun1.png", "policeRun2.png", "policeRun3.png"};
+    QueueSpriteSet(loader, &assets->protester, protesterIdle, protesterRun);
+    QueueSpriteSet(loader, &assets->police, policeIdle, policeRun);
+}
+
+void UnloadGameAssets(GameAssets *assets)
+{
+    if (assets->animShader.id != 0) UnloadShader(assets->animShader);
+    if (assets->atlas.id != 0) UnloadTexture(assets->atlas);
+}
+
+#define TELEMETRY_QUEUE_SIZE 256 // records buffered for the writer thread
+
+// Appends TelemetryRecords to a file from a background thread. The game
+// thread only fills a slot in a single-producer ring; the writer drains it,
+// so disk stalls never reach the frame.
+typedef struct
+{
+    FILE *file;
+    TelemetryRecord ring[TELEMETRY_QUEUE_SIZE];
+    atomic_uint head; // next slot the game thread fills
+    atomic_uint tail; // next slot the writer drains
+    atomic_bool stop;
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool running;
+    double interval;
+    double nextSample;
+    unsigned int dropped; // records lost because the ring was full
+} TelemetryWriter;
+
+void *TelemetryWriteThread(void *arg)
+{
+    TelemetryWriter *writer = (TelemetryWriter *)arg;
+    for (;;) {
+        pthread_mutex_lock(&writer->lock);
+        while (atomic_load(&writer->tail) == atomic_load(&writer->head) && !atomic_load(&writer->stop)) {
+            pthread_cond_wait(&writer->wake, &writer->lock);
+        }
+        pthread_mutex_unlock(&writer->lock);
+
+        unsigned int tail = atomic_load(&writer->tail);
+        unsigned int head = atomic_load(&writer->head);
+        if (tail == head) break; // stopped and drained
+        for (; tail != head; tail++) {
+            fwrite(&writer->ring[tail % TELEMETRY_QUEUE_SIZE], sizeof(TelemetryRecord), 1, writer->file);
+        }
+        atomic_store(&writer->tail, tail);
+        fflush(writer->file);
+    }
+    return NULL;
+}
+
+bool StartTelemetry(TelemetryWriter *writer, const GameState *game)
+{
+    const ScenarioConfig *scenario = &game->scenario;
+    memset(writer, 0, sizeof(TelemetryWriter));
+    if (scenario->telemetryPath == NULL) return false;
+
+    writer->file = fopen(scenario->telemetryPath, "wb");
+    if (writer->file == NULL) {
+        TraceLog(LOG_WARNING, "TELEMETRY: Could not open %s", scenario->telemetryPath);
+        return false;
+    }
+    TelemetryHeader header = {
+        .magic = TELEMETRY_MAGIC,
+        .version = TELEMETRY_VERSION,
+        .tickRate = (uint32_t)scenario->telemetryRate,
+        .worldWidth = (uint32_t)scenario->worldWidth,
+        .maxProtesters = (uint32_t)scenario->maxProtesters,
+        .maxPolice = (uint32_t)scenario->maxPolice,
+        .maxProjectiles = (uint32_t)scenario->maxProjectiles,
+        .maxGas = (uint32_t)scenario->maxGas,
+        .startTime = (int64_t)time(NULL)
+    };
+    fwrite(&header, sizeof(header), 1, writer->file);
+
+    atomic_init(&writer->head, 0);
+    atomic_init(&writer->tail, 0);
+    atomic_init(&writer->stop, false);
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->wake, NULL);
+    writer->interval = 1.0 / scenario->telemetryRate;
+    writer->running = (pthread_create(&writer->worker, NULL, TelemetryWriteThread, writer) == 0);
+    if (!writer->running) {
+        TraceLog(LOG_WARNING, "TELEMETRY: Could not start writer thread");
+        fclose(writer->file);
+        writer->file = NULL;
+        return false;
+    }
+    TraceLog(LOG_INFO, "TELEMETRY: Recording to %s at %d Hz", scenario->telemetryPath, scenario->telemetryRate);
+    return true;
+}
+
+// Takes a record at the configured rate while a match is running. One pass
+// over the packed crowd plus a ring write; everything else is off-thread.
+void SampleTelemetry(TelemetryWriter *writer, GameState *game)
+{
+    if (!writer->running || game->menuState != MENU_PLAY) return;
+    double now = game->time;
+    if (now < writer->nextSample) return;
+    writer->nextSample = now + writer->interval;
+
+    unsigned int head = atomic_load(&writer->head);
+    if (head - atomic_load(&writer->tail) >= TELEMETRY_QUEUE_SIZE) {
+        writer->dropped++;
+        return;
+    }
+    TelemetryRecord *record = &writer->ring[head % TELEMETRY_QUEUE_SIZE];
+    memset(record, 0, sizeof(TelemetryRecord));
+    record->time = (float)(now - game->gameStartTime);
+    record->morale = game->globalMorale;
+    record->control = game->controlProgress;
+    record->stateCounts[ARRESTED] = (uint32_t)game->protesters_arrested; // their slots may be reused by later waves
+
+    float cellWidth = game->worldWidth / TELEMETRY_HEAT_COLUMNS;
+    float cellHeight = (float)(FIELD_BOTTOM - FIELD_TOP) / TELEMETRY_HEAT_ROWS;
+    for (int i = 0; i < game->maxProtesters; i++) {
+        PackedProtester packed = game->crowd[i];
+        ProtesterState state = PackedState(packed);
+        if (!PackedAlive(packed)) continue;
+        record->stateCounts[state]++;
+        Vector2 pos = PackedPosition(packed, game->worldWidth);
+        int col = (int)Clamp(pos.x / cellWidth, 0, TELEMETRY_HEAT_COLUMNS - 1);
+        int row = (int)Clamp((pos.y - FIELD_TOP) / cellHeight, 0, TELEMETRY_HEAT_ROWS - 1);
+        uint8_t *cell = &record->heat[row * TELEMETRY_HEAT_COLUMNS + col];
+        if (*cell < 255) (*cell)++;
+    }
+    for (int i = 0; i < game->maxPolice; i++) {
+        if (!game->police[i].alive) continue;
+        record->police++;
+        record->policeHealth += game->police[i].health;
+    }
+    for (int i = 0; i < game->maxProjectiles; i++) {
+        if (game->projectiles[i].active) record->projectiles++;
+    }
+    for (int g = 0; g < game->maxGas; g++) {
+        if (game->gas[g].active) record->gas++;
+    }
+    for (int s = 0; s < TIMING_COUNT; s++) {
+        record->timings[s] = (game->timedTicks > 0) ? game->systemTime[s] / game->timedTicks : 0.0f;
+        game->systemTime[s] = 0.0f;
+    }
+    game->timedTicks = 0;
+
+    atomic_store(&writer->head, head + 1);
+    pthread_mutex_lock(&writer->lock);
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+void StopTelemetry(TelemetryWriter *writer)
+{
+    if (!writer->running) return;
+    pthread_mutex_lock(&writer->lock);
+    atomic_store(&writer->stop, true);
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->worker, NULL);
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->wake);
+    fclose(writer->file);
+    if (writer->dropped > 0) TraceLog(LOG_WARNING, "TELEMETRY: %u records dropped", writer->dropped);
+    writer->running = false;
+}
+
+// Session recording. Frames are read back from the GPU asynchronously: each
+// frame's glReadPixels goes into a pixel buffer object and is fenced, and
+// the buffer is mapped only once a later frame finds the fence signalled,
+// so the render thread never waits on the GPU. Mapped buffers go straight
+// to encoder threads, which convert them into a YUV4MPEG2 stream (path
+// ending in .y4m) or a numbered PNG sequence, then hand them back to be
+// unmapped and reused. When every buffer is busy the frame is dropped.
+#if defined(_WIN32)
+#define GL_CALL __stdcall
+#else
+#define GL_CALL
+#endif
+#define GL_PIXEL_PACK_BUFFER_ 0x88EB
+#define GL_STREAM_READ_ 0x88E1
+#define GL_MAP_READ_BIT_ 0x0001
+#define GL_RGBA_ 0x1908
+#define GL_UNSIGNED_BYTE_ 0x1401
+#define GL_SYNC_GPU_COMMANDS_COMPLETE_ 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT_ 0x0001
+#define GL_ALREADY_SIGNALED_ 0x911A
+#define GL_CONDITION_SATISFIED_ 0x911C
+
+// GL 3.x entry points rlgl does not expose
+typedef struct
+{
+    void (GL_CALL *GenBuffers)(int count, unsigned int *buffers);
+    void (GL_CALL *DeleteBuffers)(int count, const unsigned int *buffers);
+    void (GL_CALL *BindBuffer)(unsigned int target, unsigned int buffer);
+    void (GL_CALL *BufferData)(unsigned int target, ptrdiff_t size, const void *data, unsigned int usage);
+    void *(GL_CALL *MapBufferRange)(unsigned int target, ptrdiff_t offset, ptrdiff_t length, unsigned int access);
+    unsigned char (GL_CALL *UnmapBuffer)(unsigned int target);
+    void (GL_CALL *ReadPixels)(int x, int y, int width, int height, unsigned int format, unsigned int type, void *pixels);
+    void *(GL_CALL *FenceSync)(unsigned int condition, unsigned int flags);
+    unsigned int (GL_CALL *ClientWaitSync)(void *sync, unsigned int flags, uint64_t timeout);
+    void (GL_CALL *DeleteSync)(void *sync);
+} ReadbackGL;
+
+static bool LoadReadbackGL(ReadbackGL *gl)
+{
+    static const char *const names[] = {
+        "glGenBuffers", "glDeleteBuffers", "glBindBuffer", "glBufferData", "glMapBufferRange",
+        "glUnmapBuffer", "glReadPixels", "glFenceSync", "glClientWaitSync", "glDeleteSync"
+    };
+    _Static_assert(sizeof(ReadbackGL) == sizeof(names) / sizeof(names[0]) * sizeof(void *), "one name per entry point");
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        void *proc = PlatformGLProc(names[i]);
+        if (proc == NULL) return false;
+        memcpy((char *)gl + i * sizeof(void *), &proc, sizeof(proc));
+    }
+    return true;
+}
+
+typedef enum
+{
+    RECORD_FREE,     // unmapped, ready for a readback
+    RECORD_READING,  // readback issued, waiting on its fence
+    RECORD_QUEUED,   // mapped, waiting for an encoder
+    RECORD_ENCODING,
+    RECORD_ENCODED   // done with, to be unmapped by the render thread
+} RecordSlotState;
+
+typedef struct
+{
+    unsigned int buffer;
+    void *fence;
+    const uint8_t *pixels; // mapped while queued or encoding; bottom row first
+    uint32_t issued;       // readback order
+    uint32_t sequence;     // position in the output
+    RecordSlotState state; // guarded by the recorder's lock
+} RecordSlot;
+
+typedef struct FrameRecorder FrameRecorder;
+
+typedef struct
+{
+    FrameRecorder *recorder;
+    uint8_t *scratch; // one converted frame
+    pthread_t thread;
+} FrameEncoder;
+
+struct FrameRecorder
+{
+    bool running;
+    bool y4m;
+    const char *path;
+    FILE *stream; // y4m only
+    int width;
+    int height;
+    size_t frameSize; // RGBA bytes
+    ReadbackGL gl;
+    RecordSlot slots[RECORD_BUFFERS];
+    uint32_t issued;
+    uint32_t queued;  // sequence numbers handed out
+    uint32_t written; // frames finished, in sequence order for y4m; guarded by writeLock
+    unsigned int dropped;
+    bool stop;        // guarded by lock
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_mutex_t writeLock;
+    pthread_cond_t turn;
+    FrameEncoder encoders[RECORD_ENCODER_THREADS];
+    int encoderCount;
+    uint8_t *scratchBlock;
+};
+
+// BT.601 studio range, chroma averaged over each 2x2 block. The source is
+// bottom row first, as glReadPixels returns it.
+static void ConvertFrameToYuv(const FrameRecorder *rec, const uint8_t *rgba, uint8_t *yuv)
+{
+    int w = rec->width;
+    int h = rec->height;
+    uint8_t *yPlane = yuv;
+    uint8_t *uPlane = yuv + w * h;
+    uint8_t *vPlane = uPlane + (w / 2) * (h / 2);
+    for (int y = 0; y < h; y++) {
+        const uint8_t *row = rgba + (size_t)(h - 1 - y) * w * 4;
+        for (int x = 0; x < w; x++) {
+            int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+            yPlane[y * w + x] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        }
+    }
+    for (int y = 0; y < h / 2; y++) {
+        const uint8_t *row0 = rgba + (size_t)(h - 1 - 2 * y) * w * 4;
+        const uint8_t *row1 = row0 - (size_t)w * 4;
+        for (int x = 0; x < w / 2; x++) {
+            const uint8_t *a = row0 + x * 8, *c = row1 + x * 8;
+            int r = (a[0] + a[4] + c[0] + c[4] + 2) >> 2;
+            int g = (a[1] + a[5] + c[1] + c[5] + 2) >> 2;
+            int b = (a[2] + a[6] + c[2] + c[6] + 2) >> 2;
+            uPlane[y * (w / 2) + x] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[y * (w / 2) + x] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+// Flips to top row first and makes the frame opaque
+static void ConvertFrameToImage(const FrameRecorder *rec, const uint8_t *rgba, uint8_t *out)
+{
+    size_t stride = (size_t)rec->width * 4;
+    for (int y = 0; y < rec->height; y++) {
+        uint8_t *row = out + y * stride;
+        memcpy(row, rgba + (rec->height - 1 - y) * stride, stride);
+        for (int x = 0; x < rec->width; x++) row[x * 4 + 3] = 255;
+    }
+}
+
+static void *FrameEncodeThread(void *arg)
+{
+    FrameEncoder *encoder = (FrameEncoder *)arg;
+    FrameRecorder *rec = encoder->recorder;
+    for (;;) {
+        pthread_mutex_lock(&rec->lock);
+        RecordSlot *slot = NULL;
+        for (;;) {
+            for (int s = 0; s < RECORD_BUFFERS; s++) {
+                RecordSlot *candidate = &rec->slots[s];
+                if (candidate->state != RECORD_QUEUED) continue;
+                if (slot == NULL || candidate->sequence < slot->sequence) slot = candidate;
+            }
+            if (slot != NULL || rec->stop) break;
+            pthread_cond_wait(&rec->wake, &rec->lock);
+        }
+        if (slot == NULL) {
+            pthread_mutex_unlock(&rec->lock);
+            break;
+        }
+        slot->state = RECORD_ENCODING;
+        pthread_mutex_unlock(&rec->lock);
+
+        uint32_t sequence = slot->sequence;
+        if (rec->y4m) ConvertFrameToYuv(rec, slot->pixels, encoder->scratch);
+        else ConvertFrameToImage(rec, slot->pixels, encoder->scratch);
+        pthread_mutex_lock(&rec->lock);
+        slot->state = RECORD_ENCODED;
+        pthread_mutex_unlock(&rec->lock);
+
+        if (rec->y4m) {
+            // Frames may finish out of order; the stream takes them in order
+            pthread_mutex_lock(&rec->writeLock);
+            while (rec->written != sequence) pthread_cond_wait(&rec->turn, &rec->writeLock);
+            fputs("FRAME\n", rec->stream);
+            fwrite(encoder->scratch, 1, (size_t)rec->width * rec->height * 3 / 2, rec->stream);
+            rec->written++;
+            pthread_cond_broadcast(&rec->turn);
+            pthread_mutex_unlock(&rec->writeLock);
+        } else {
+            Image image = {encoder->scratch, rec->width, rec->height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+            char fileName[512];
+            snprintf(fileName, sizeof(fileName), "%s%05u.png", rec->path, sequence); // TextFormat is not thread-safe
+            ExportImage(image, fileName);
+            pthread_mutex_lock(&rec->writeLock);
+            rec->written++;
+            pthread_mutex_unlock(&rec->writeLock);
+        }
+    }
+    return NULL;
+}
+
+static void SetRecordSlotState(FrameRecorder *rec, RecordSlot *slot, RecordSlotState state)
+{
+    pthread_mutex_lock(&rec->lock);
+    slot->state = state;
+    if (state == RECORD_QUEUED) {
+        slot->sequence = rec->queued++;
+        pthread_cond_signal(&rec->wake);
+    }
+    pthread_mutex_unlock(&rec->lock);
+}
+
+// Returns encoded buffers to the pool and maps finished readbacks, oldest
+// first. Without `wait` it stops at the first readback still in flight.
+static void CollectReadbacks(FrameRecorder *rec, bool wait)
+{
+    ReadbackGL *gl = &rec->gl;
+    RecordSlotState states[RECORD_BUFFERS];
+    pthread_mutex_lock(&rec->lock);
+    for (int s = 0; s < RECORD_BUFFERS; s++) states[s] = rec->slots[s].state;
+    pthread_mutex_unlock(&rec->lock);
+
+    for (int s = 0; s < RECORD_BUFFERS; s++) {
+        if (states[s] != RECORD_ENCODED) continue;
+        gl->BindBuffer(GL_PIXEL_PACK_BUFFER_, rec->slots[s].buffer);
+        gl->UnmapBuffer(GL_PIXEL_PACK_BUFFER_);
+        rec->slots[s].pixels = NULL;
+        SetRecordSlotState(rec, &rec->slots[s], RECORD_FREE);
+    }
+
+    for (;;) {
+        RecordSlot *oldest = NULL;
+        for (int s = 0; s < RECORD_BUFFERS; s++) {
+            RecordSlot *slot = &rec->slots[s];
+            if (states[s] == RECORD_READING && (oldest == NULL || slot->issued < oldest->issued)) oldest = slot;
+        }
+        if (oldest == NULL) break;
+        unsigned int status = gl->ClientWaitSync(oldest->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT_ : 0, wait ? 1000000000u : 0u);
+        if (status != GL_ALREADY_SIGNALED_ && status != GL_CONDITION_SATISFIED_ && !wait) break;
+        gl->DeleteSync(oldest->fence);
+        oldest->fence = NULL;
+        states[oldest - rec->slots] = RECORD_QUEUED;
+        gl->BindBuffer(GL_PIXEL_PACK_BUFFER_, oldest->buffer);
+        oldest->pixels = gl->MapBufferRange(GL_PIXEL_PACK_BUFFER_, 0, (ptrdiff_t)rec->frameSize, GL_MAP_READ_BIT_);
+        if (oldest->pixels == NULL) {
+            rec->dropped++;
+            SetRecordSlotState(rec, oldest, RECORD_FREE);
+            continue;
+        }
+        SetRecordSlotState(rec, oldest, RECORD_QUEUED);
+    }
+    gl->BindBuffer(GL_PIXEL_PACK_BUFFER_, 0);
+}
+
+// Queues a readback of the frame just drawn; call right before EndDrawing
+void CaptureFrame(FrameRecorder *rec)
+{
+    if (!rec->running) return;
+    CollectReadbacks(rec, false);
+
+    RecordSlot *slot = NULL;
+    pthread_mutex_lock(&rec->lock);
+    for (int s = 0; s < RECORD_BUFFERS && slot == NULL; s++) {
+        if (rec->slots[s].state == RECORD_FREE) slot = &rec->slots[s];
+    }
+    pthread_mutex_unlock(&rec->lock);
+    if (slot == NULL) {
+        rec->dropped++;
+        return;
+    }
+
+    rlDrawRenderBatchActive(); // the readback has to see everything drawn this frame
+    ReadbackGL *gl = &rec->gl;
+    gl->BindBuffer(GL_PIXEL_PACK_BUFFER_, slot->buffer);
+    gl->ReadPixels(0, 0, rec->width, rec->height, GL_RGBA_, GL_UNSIGNED_BYTE_, NULL);
+    gl->BindBuffer(GL_PIXEL_PACK_BUFFER_, 0);
+    slot->fence = gl->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE_, 0);
+    slot->issued = rec->issued++;
+    SetRecordSlotState(rec, slot, RECORD_READING);
+}
+
+// Waits for the frames still in flight and finishes the output
+void StopFrameRecorder(FrameRecorder *rec)
+{
+    if (!rec->running) return;
+    CollectReadbacks(rec, true);
+    pthread_mutex_lock(&rec->lock);
+    rec->stop = true;
+    pthread_cond_broadcast(&rec->wake);
+    pthread_mutex_unlock(&rec->lock);
+    for (int e = 0; e < rec->encoderCount; e++) pthread_join(rec->encoders[e].thread, NULL);
+    CollectReadbacks(rec, true);
+
+    for (int s = 0; s < RECORD_BUFFERS; s++) rec->gl.DeleteBuffers(1, &rec->slots[s].buffer);
+    pthread_mutex_destroy(&rec->lock);
+    pthread_cond_destroy(&rec->wake);
+    pthread_mutex_destroy(&rec->writeLock);
+    pthread_cond_destroy(&rec->turn);
+    if (rec->stream != NULL) fclose(rec->stream);
+    free(rec->scratchBlock);
+    TraceLog(LOG_INFO, "RECORD: %u frames written, %u dropped", rec->written, rec->dropped);
+    rec->running = false;
+}
+
+bool StartFrameRecorder(FrameRecorder *rec, const char *path)
+{
+    memset(rec, 0, sizeof(FrameRecorder));
+    if (path == NULL) return false;
+    if (!LoadReadbackGL(&rec->gl)) {
+        TraceLog(LOG_WARNING, "RECORD: Asynchronous readback is not available, not recording");
+        return false;
+    }
+    rec->path = path;
+    rec->width = GetRenderWidth() & ~1; // 4:2:0 chroma needs even sizes
+    rec->height = GetRenderHeight() & ~1;
+    rec->frameSize = (size_t)rec->width * rec->height * 4;
+    size_t length = strlen(path);
+    rec->y4m = length >= 4 && strcmp(path + length - 4, ".y4m") == 0;
+    if (rec->y4m) {
+        rec->stream = fopen(path, "wb");
+        if (rec->stream == NULL) {
+            TraceLog(LOG_WARNING, "RECORD: Could not open %s", path);
+            return false;
+        }
+        fprintf(rec->stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", rec->width, rec->height, TARGET_FPS);
+    }
+    rec->scratchBlock = malloc(rec->frameSize * RECORD_ENCODER_THREADS);
+    if (rec->scratchBlock == NULL) {
+        if (rec->stream != NULL) fclose(rec->stream);
+        return false;
+    }
+
+    for (int s = 0; s < RECORD_BUFFERS; s++) {
+        rec->gl.GenBuffers(1, &rec->slots[s].buffer);
+        rec->gl.BindBuffer(GL_PIXEL_PACK_BUFFER_, rec->slots[s].buffer);
+        rec->gl.BufferData(GL_PIXEL_PACK_BUFFER_, (ptrdiff_t)rec->frameSize, NULL, GL_STREAM_READ_);
+    }
+    rec->gl.BindBuffer(GL_PIXEL_PACK_BUFFER_, 0);
+
+    pthread_mutex_init(&rec->lock, NULL);
+    pthread_cond_init(&rec->wake, NULL);
+    pthread_mutex_init(&rec->writeLock, NULL);
+    pthread_cond_init(&rec->turn, NULL);
+    for (; rec->encoderCount < RECORD_ENCODER_THREADS; rec->encoderCount++) {
+        FrameEncoder *encoder = &rec->encoders[rec->encoderCount];
+        encoder->recorder = rec;
+        encoder->scratch = rec->scratchBlock + rec->frameSize * rec->encoderCount;
+        if (pthread_create(&encoder->thread, NULL, FrameEncodeThread, encoder) != 0) break;
+    }
+    rec->running = true;
+    if (rec->encoderCount == 0) {
+        TraceLog(LOG_WARNING, "RECORD: Could not start encoder threads");
+        StopFrameRecorder(rec);
+        return false;
+    }
+    TraceLog(LOG_INFO, "RECORD: Capturing %dx%d to %s%s", rec->width, rec->height, path, rec->y4m ? "" : "#####.png");
+    return true;
+}
+
+// Input-to-photon latency. Times are measured from the moment raylib polls
+// input events, the earliest the game can see them, to the first simulation
+// tick that applies them and to the swap that shows the result.
+//
+// With default pacing EndDrawing polls straight after the swap and the
+// frame then sleeps out its budget, so input waits through that sleep
+// before it is simulated. Low-latency mode moves the sleep ahead of the
+// poll: it presents with SwapScreenBuffer itself, sleeps until only a
+// frame's expected work is left, polls with PollInputEvents and steps the
+// simulation in fixed ticks, so input always lands on a tick boundary.
+typedef struct
+{
+    bool lowLatency;
+    bool overlay;          // toggled with F3
+    double polledAt;       // when input was last polled
+    double frameTime;      // between the last two polls
+    double appliedAt;      // when this frame's first tick started
+    double commandAt;      // sampledAt of this frame's command, 0 if none
+    bool played;           // this frame ran the simulation
+    double deadline;       // low-latency mode: when the next present is due
+    double workEstimate;   // low-latency mode: poll to present, decaying peak
+    double owed;           // low-latency mode: simulation time not yet ticked
+    float toSim[LATENCY_WINDOW];     // ms, ring of recent played frames
+    float toPresent[LATENCY_WINDOW];
+    int head;
+    int count;
+    float lastCommand;     // ms from poll to present of the latest command
+    double logSim;         // sums since the last log line
+    double logPresent;
+    float logPeak;
+    int logFrames;
+    double nextLog;
+} LatencyMonitor;
+
+void StartLatencyMonitor(LatencyMonitor *latency, bool lowLatency)
+{
+    *latency = (LatencyMonitor){0};
+    latency->lowLatency = lowLatency;
+    latency->polledAt = GetTime();
+    latency->frameTime = FRAME_BUDGET;
+    latency->deadline = latency->polledAt;
+    latency->nextLog = latency->polledAt + LATENCY_LOG_INTERVAL;
+    if (lowLatency) TraceLog(LOG_INFO, "LATENCY: Low-latency mode, input polled late and simulated in %d Hz ticks", TARGET_FPS);
+}
+
+static void NoteInputPolled(LatencyMonitor *latency, double now)
+{
+    latency->frameTime = now - latency->polledAt;
+    latency->polledAt = now;
+}
+
+static void LogLatency(LatencyMonitor *latency)
+{
+    if (latency->logFrames > 0) {
+        TraceLog(LOG_INFO, "LATENCY: input to sim %.2f ms, to present %.2f ms mean, %.2f ms peak over %d frames",
+                 latency->logSim / latency->logFrames, latency->logPresent / latency->logFrames, latency->logPeak, latency->logFrames);
+    }
+    latency->logSim = 0.0;
+    latency->logPresent = 0.0;
+    latency->logPeak = 0.0f;
+    latency->logFrames = 0;
+}
+
+// Low-latency mode: waits until only the expected work of a frame is left
+// before its present is due, then polls input
+void PollInputLate(LatencyMonitor *latency)
+{
+    double now = GetTime();
+    latency->deadline += FRAME_BUDGET;
+    double wake = latency->deadline - latency->workEstimate - LATENCY_MARGIN;
+    if (wake < now) {
+        // Behind schedule: present as soon as the work allows and pace on from there
+        latency->deadline = now + latency->workEstimate + LATENCY_MARGIN;
+    } else {
+        WaitTime(wake - now);
+    }
+    PollInputEvents();
+    NoteInputPolled(latency, GetTime());
+}
+
+static void NoteCommand(LatencyMonitor *latency, const InputState *input)
+{
+    if (input->sampledAt > 0.0 &&
+        (input->selectPressed || input->selectReleased || input->commandPressed || input->selectAllPressed ||
+         input->retreatPressed || input->throwPressed || input->barricadePressed)) {
+        latency->commandAt = input->sampledAt;
+    }
+}
+
+// Advances play by one frame. Low-latency mode runs the fixed ticks owed
+// since the last frame; the frame's input goes to the first of them and
+// catch-up ticks run without any.
+void StepGameFrame(GameState *game, LatencyMonitor *latency, float frameTime)
+{
+    latency->appliedAt = GetTime();
+    latency->played = true;
+    if (!latency->lowLatency) {
+        UpdateGame(game, frameTime);
+        NoteCommand(latency, &game->input);
+        return;
+    }
+    latency->owed = fmin(latency->owed + frameTime, LATENCY_MAX_CATCHUP * FRAME_BUDGET);
+    int ticks = (int)(latency->owed / FRAME_BUDGET + 0.5);
+    if (ticks < 1) ticks = 1; // paced frames are never much early, and the input must not be lost
+    latency->owed -= ticks * FRAME_BUDGET;
+    // The frame arena is sized for one tick plus the draw list, so each
+    // tick's scratch (events, solver, grids) is released before the next
+    InputSource *source = game->inputSource;
+    for (int tick = 0; tick < ticks; tick++) {
+        size_t mark = game->frameArena.used;
+        UpdateGame(game, (float)FRAME_BUDGET);
+        if (tick == 0) NoteCommand(latency, &game->input);
+        game->frameArena.used = mark;
+        game->events = (EventQueue){0};
+        game->inputSource = NULL;
+    }
+    game->inputSource = source;
+}
+
+// Shows the frame and records how long its input took to reach the screen
+double PresentFrame(LatencyMonitor *latency)
+{
+    if (latency->lowLatency) {
+        rlDrawRenderBatchActive();
+        SwapScreenBuffer();
+    } else {
+        EndDrawing();
+    }
+    double now = GetTime();
+    if (latency->lowLatency) {
+        // Rises at once to a slow frame and sinks back by 1% of the budget per frame
+        latency->workEstimate = fmax(now - latency->polledAt, latency->workEstimate - FRAME_BUDGET * 0.01);
+    }
+
+    if (latency->played) {
+        float toSim = (float)((latency->appliedAt - latency->polledAt) * 1000.0);
+        float toPresent = (float)((now - latency->polledAt) * 1000.0);
+        latency->toSim[latency->head] = toSim;
+        latency->toPresent[latency->head] = toPresent;
+        latency->head = (latency->head + 1) % LATENCY_WINDOW;
+        if (latency->count < LATENCY_WINDOW) latency->count++;
+        if (latency->commandAt > 0.0) latency->lastCommand = (float)((now - latency->commandAt) * 1000.0);
+        latency->logSim += toSim;
+        latency->logPresent += toPresent;
+        latency->logPeak = fmaxf(latency->logPeak, toPresent);
+        latency->logFrames++;
+    }
+    latency->played = false;
+    latency->commandAt = 0.0;
+    if (now >= latency->nextLog) {
+        LogLatency(latency);
+        latency->nextLog = now + LATENCY_LOG_INTERVAL;
+    }
+
+    // EndDrawing polled input right after its swap
+    if (!latency->lowLatency) NoteInputPolled(latency, now);
+    return now;
+}
+
+void StopLatencyMonitor(LatencyMonitor *latency)
+{
+    LogLatency(latency);
+}
+
+static void LatencyStats(const float *samples, int count, float *mean, float *p95)
+{
+    float sorted[LATENCY_WINDOW];
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float value = samples[i];
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > value; j--) sorted[j] = sorted[j - 1];
+        sorted[j] = value;
+        sum += value;
+    }
+    *mean = sum / count;
+    *p95 = sorted[(int)(0.95f * (count - 1))];
+}
+
+void DrawLatencyOverlay(const LatencyMonitor *latency, Font font)
+{
+    if (!latency->overlay) return;
+    int y = GetScreenHeight() - 120;
+    DrawRectangle(10, y, 440, 110, Fade(BLACK, 0.6f));
+    DrawTextEx(font, latency->lowLatency ? "Input latency, low-latency mode" : "Input latency", (Vector2){20, (float)y + 8}, 20, 1, WHITE);
+    if (latency->count == 0) return;
+    float mean, p95;
+    LatencyStats(latency->toSim, latency->count, &mean, &p95);
+    DrawTextEx(font, TextFormat("to sim      %5.1f ms   p95 %5.1f ms", mean, p95), (Vector2){20, (float)y + 34}, 20, 1, WHITE);
+    LatencyStats(latency->toPresent, latency->count, &mean, &p95);
+    DrawTextEx(font, TextFormat("to present  %5.1f ms   p95 %5.1f ms", mean, p95), (Vector2){20, (float)y + 58}, 20, 1, WHITE);
+    DrawTextEx(font, TextFormat("last command  %5.1f ms", latency->lastCommand), (Vector2){20, (float)y + 82}, 20, 1, WHITE);
+}
+
+// Short effects are synthesized at startup rather than shipped. Each is a
+// mono 16-bit wave built from noise, sines and an envelope.
+typedef struct
+{
+    float duration; // seconds
+    float volume;   // at the listener
+    float priority; // against other effects when voices run out
+} EffectInfo;
+
+static const EffectInfo EFFECT_INFO[SFX_COUNT] = {
+    [SFX_STONE] = {0.12f, 0.5f, 1.0f},
+    [SFX_BULLET] = {0.25f, 0.7f, 2.0f},
+    [SFX_GAS] = {0.9f, 0.6f, 3.0f},
+    [SFX_ARREST] = {0.5f, 0.6f, 3.0f},
+    [SFX_HELICOPTER] = {2.0f, 0.9f, 5.0f},
+};
+
+static Wave SynthesizeEffect(SoundEffect effect)
+{
+    Wave wave = {0};
+    wave.sampleRate = AUDIO_SAMPLE_RATE;
+    wave.sampleSize = 16;
+    wave.channels = 1;
+    wave.frameCount = (unsigned int)(EFFECT_INFO[effect].duration * AUDIO_SAMPLE_RATE);
+    short *samples = malloc(sizeof(short) * wave.frameCount);
+    if (samples == NULL) return (Wave){0};
 
-            float closestDist = 150.0f;
-            for (int j = 0; j < MAX_PROTESTERS; j++) {
-                if (!game->protesters[j].alive) continue;
-                float dist = Vector2Distance(p->pos, game->protesters[j].pos);
-                if (dist < closestDist && game->protesters[j].state != FLEE) {
-                    p->state = DEPLOY;
-                    p->timer = 3.0f;
-                    break;
-                }
-            }
+    uint64_t noiseState = SeedRandom(0x5EED + effect);
+    float low = 0.0f;
+    for (unsigned int i = 0; i < wave.frameCount; i++) {
+        float t = (float)i / AUDIO_SAMPLE_RATE;
+        float noise = NextRandom(&noiseState, -1000, 1000) / 1000.0f;
+        low += 0.15f * (noise - low);
+        float value = 0.0f;
+        switch (effect) {
+        case SFX_STONE: // dull knock: filtered noise over a low thump
+            value = (0.7f * low + 0.5f * sinf(2.0f * PI * 120.0f * t)) * expf(-t * 40.0f);
             break;
-        }
-        case DEPLOY: {
-            for (int g = 0; g < MAX_GAS; g++) {
-                if (!game->gas[g].active) {
-                    float closestDist = 200.0f;
-                    Vector2 targetPos = p->pos;
-                    for (int j = 0; j < MAX_PROTESTERS; j++) {
-                        if (!game->protesters[j].alive) continue;
-                        float dist = Vector2Distance(p->pos, game->protesters[j].pos);
-                        if (dist < closestDist) {
-                            closestDist = dist;
-                            targetPos = game->protesters[j].pos;
-                        }
-                    }
-                    if (closestDist < 200.0f) {
-                        game->gas[g].pos = targetPos;
-                        game->gas[g].radius = 5.0f;
-                        game->gas[g].timer = 0.0f;
-                        game->gas[g].active = true;
-                    }
-                    break;
-                }
-            }
-            if (p->timer <= 0.0f) {
-                p->state = PATROL;
-            }
+        case SFX_BULLET: // crack: raw noise with a very fast decay
+            value = noise * expf(-t * 25.0f);
+            break;
+        case SFX_GAS: { // pop, then a hiss of high-passed noise
+            float fade = 1.0f - t / EFFECT_INFO[SFX_GAS].duration;
+            value = (noise - low) * fminf(t / 0.02f, 1.0f) * 0.6f * fade * fade + low * expf(-t * 60.0f);
             break;
         }
-        case INTERVENE: {
-            Vector2 centerOfProtest = {0, 0};
-            int protestCount = 0;
-            for (int j = 0; j < MAX_PROTESTERS; j++) {
-                if (game->protesters[j].alive && game->protesters[j].state != FLEE) {
-                    centerOfProtest = Vector2Add(centerOfProtest, game->protesters[j].pos);
-                    protestCount++;
-                }
-            }
-            if (protestCount > 0) {
-                centerOfProtest = Vector2Scale(centerOfProtest, 1.0f / protestCount);
-                Vector2 toCenter = Vector2Subtract(centerOfProtest, p->pos);
-                if (Vector2Length(toCenter) > 5.0f) {
-                    p->vel = Vector2Scale(Vector2Normalize(toCenter), 2.0f);
-                }
-            }
+        case SFX_ARREST: { // two trilled whistle blasts
+            float blast = (t < 0.2f || (t > 0.28f && t < 0.48f)) ? 1.0f : 0.0f;
+            value = 0.4f * blast * sinf(2.0f * PI * (2800.0f * t + 3.0f * sinf(2.0f * PI * 30.0f * t)));
             break;
         }
-        case ARREST: {
-            for (int j = 0; j < MAX_PROTESTERS; j++) {
-                if (game->protesters[j].alive && game->protesters[j].state == FLEE &&
-                    Vector2Distance(p->pos, game->protesters[j].pos) < 25.0f) {
-                    game->protesters[j].state = ARRESTED;
-                    game->protesters[j].alive = false;
-                    game->globalMorale -= 5.0f;
-                    game->protesters_arrested++;
-                    p->state = PATROL;
-                    break;
-                }
-            }
+        case SFX_HELICOPTER: { // rotor thumps fading in and out
+            float thump = powf(0.5f + 0.5f * sinf(2.0f * PI * 12.0f * t), 4.0f);
+            float fade = fminf(fminf(t / 0.5f, (EFFECT_INFO[SFX_HELICOPTER].duration - t) / 0.5f), 1.0f);
+            value = 1.5f * low * thump * fade;
             break;
         }
+        default:
+            break;
         }
-        p->pos = Vector2Add(p->pos, p->vel);
-        p->pos.x = Clamp(p->pos.x, 16, 1584);
-        p->pos.y = Clamp(p->pos.y, 318, 724);
+        samples[i] = (short)(Clamp(value, -1.0f, 1.0f) * 32767.0f);
     }
-    game->policeCount = activePolice;
+    wave.data = samples;
+    return wave;
 }
 
-void UpdateTearGas(GameState *game)
+typedef struct
 {
-    for (int g = 0; g < MAX_GAS; g++)
-    {
-        if (game->gas[g].active)
-        {
-            game->gas[g].radius += 25.0f * GetFrameTime();
-            game->gas[g].timer += GetFrameTime();
+    uint8_t effect;
+    float volume;
+    float pan; // 0.5 is centred
+    float priority;
+} AudioCommand;
 
-            for (int j = 0; j < MAX_PROTESTERS; j++)
-            {
-                if (!game->protesters[j].alive || game->protesters[j].state == FLEE)
-                    continue;
+typedef struct
+{
+    int effect; // -1 while the voice is free
+    float priority;
+    uint64_t started; // order of allocation, to steal the oldest of equals
+} AudioVoice;
 
-                float dist = Vector2Distance(game->gas[g].pos, game->protesters[j].pos);
-                if (dist < game->gas[g].radius)
-                {
-                    game->protesters[j].state = FLEE;
-                    game->protesters[j].morale -= 15;
-                    game->protesters[j].behavior_timer = 0.0f;
-                    game->globalMorale -= 0.5f;
-                    game->protesters[j].target_pos = (Vector2){50, game->protesters[j].pos.y};
-                }
-            }
+typedef enum
+{
+    MUSIC_STOPPED,
+    MUSIC_PLAYING,
+    MUSIC_PAUSED
+} MusicState;
 
-            if (game->gas[g].timer > 5.0f || game->gas[g].radius > 100.0f)
-            {
-                game->gas[g].active = false;
+// Owns every audio device call once started: it streams the music and
+// mixes one-shots on its own thread, so decoding and voice management never
+// land on the frame. The game thread only fills a single-producer command
+// ring. At most AUDIO_MAX_VOICES effects play at once; every voice slot has
+// an alias of each effect, so any slot can play any sound without copying
+// sample data, and a full set of voices gives way to a more important
+// request by stopping the least important one.
+struct AudioSystem
+{
+    Music music;
+    Sound effects[SFX_COUNT];
+    Sound aliases[SFX_COUNT][AUDIO_MAX_VOICES];
+    AudioVoice voices[AUDIO_MAX_VOICES];
+    uint64_t voiceClock;
+    MusicState musicState; // what the thread last applied
+
+    AudioCommand ring[AUDIO_QUEUE_SIZE];
+    atomic_uint head; // next slot the game thread fills
+    atomic_uint tail; // next slot the audio thread drains
+    atomic_int requestedMusic; // MusicState set by the game thread
+    atomic_bool stop;
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool running;
+
+    // Game thread only: the listener, and this frame's loudest requests,
+    // so a burst of a thousand stones still queues AUDIO_MAX_VOICES commands
+    Vector2 listener;
+    float reach; // world distance at which sounds fall silent
+    AudioCommand batch[AUDIO_MAX_VOICES];
+    int batchCount;
+    unsigned int dropped; // commands lost because the ring was full
+};
+
+static void PlayAudioCommand(AudioSystem *audio, const AudioCommand *command)
+{
+    int slot = -1;
+    for (int v = 0; v < AUDIO_MAX_VOICES && slot < 0; v++) {
+        if (audio->voices[v].effect < 0) slot = v;
+    }
+    if (slot < 0) {
+        for (int v = 0; v < AUDIO_MAX_VOICES; v++) {
+            const AudioVoice *voice = &audio->voices[v];
+            if (voice->priority > command->priority) continue;
+            if (slot < 0 || voice->priority < audio->voices[slot].priority ||
+                (voice->priority == audio->voices[slot].priority && voice->started < audio->voices[slot].started)) {
+                slot = v;
             }
         }
+        if (slot < 0) return; // everything playing matters more
+        StopSound(audio->aliases[audio->voices[slot].effect][slot]);
     }
+
+    Sound sound = audio->aliases[command->effect][slot];
+    SetSoundVolume(sound, command->volume);
+    SetSoundPan(sound, command->pan);
+    PlaySound(sound);
+    audio->voices[slot] = (AudioVoice){command->effect, command->priority, audio->voiceClock++};
 }
 
-int FindInactiveProjectile(GameState *game) {
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (!game->projectiles[i].active) return i;
-    }
-    return -1;
+static void ApplyMusicState(AudioSystem *audio, MusicState wanted)
+{
+    if (wanted == audio->musicState || audio->music.stream.buffer == NULL) return;
+    if (wanted == MUSIC_STOPPED) StopMusicStream(audio->music);
+    else if (wanted == MUSIC_PAUSED) PauseMusicStream(audio->music);
+    else if (audio->musicState == MUSIC_PAUSED) ResumeMusicStream(audio->music);
+    else PlayMusicStream(audio->music);
+    audio->musicState = wanted;
 }
 
-void FireStone(GameState *game, Vector2 pos, Vector2 dir, int owner_id) {
-    int idx = FindInactiveProjectile(game);
-    if (idx < 0) return;
-    
-    // Find the nearest police as the target
-    Vector2 targetDir = dir;
-    float closestDist = 9999.0f;
-    int closestPolice = -1;
-    for (int i = 0; i < MAX_POLICE; i++) {
-        if (game->police[i].alive) {
-            float dist = Vector2Distance(pos, game->police[i].pos);
-            if (dist < closestDist) {
-                closestDist = dist;
-                closestPolice = i;
+void *AudioThread(void *arg)
+{
+    AudioSystem *audio = (AudioSystem *)arg;
+    while (!atomic_load(&audio->stop)) {
+        for (int v = 0; v < AUDIO_MAX_VOICES; v++) {
+            AudioVoice *voice = &audio->voices[v];
+            if (voice->effect >= 0 && !IsSoundPlaying(audio->aliases[voice->effect][v])) voice->effect = -1;
+        }
+        unsigned int tail = atomic_load(&audio->tail);
+        unsigned int head = atomic_load(&audio->head);
+        for (; tail != head; tail++) PlayAudioCommand(audio, &audio->ring[tail % AUDIO_QUEUE_SIZE]);
+        atomic_store(&audio->tail, tail);
+
+        ApplyMusicState(audio, (MusicState)atomic_load(&audio->requestedMusic));
+        if (audio->musicState == MUSIC_PLAYING) UpdateMusicStream(audio->music);
+
+        // Wake for new commands, or often enough to keep the stream fed
+        pthread_mutex_lock(&audio->lock);
+        if (atomic_load(&audio->tail) == atomic_load(&audio->head) && !atomic_load(&audio->stop)) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += AUDIO_PERIOD_MS * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
             }
+            pthread_cond_timedwait(&audio->wake, &audio->lock, &deadline);
         }
+        pthread_mutex_unlock(&audio->lock);
     }
-    if (closestPolice != -1) {
-        targetDir = Vector2Subtract(game->police[closestPolice].pos, pos);
-    }
-    
-    game->projectiles[idx].active = true;
-    game->projectiles[idx].pos = pos;
-    Vector2 norm = Vector2Normalize(targetDir);
-    if (Vector2Length(norm) < 0.01f) norm = (Vector2){1,0};
-    game->projectiles[idx].vel = Vector2Scale(norm, 350.0f);
-    game->projectiles[idx].owner_id = owner_id;
-    game->projectiles[idx].lifetime = 0.0f;
-    game->projectiles[idx].distance = 0.0f;
-    game->projectiles[idx].max_distance = 320.0f;
-    game->projectiles[idx].type = STONE;
-    game->projectiles[idx].damage = 25.0f;
+    return NULL;
 }
 
-void ShootBullet(GameState *game, Police* p, Vector2 target) {
-    if (police_cooldown[p->id] > 0) return;
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (!game->projectiles[i].active) {
-            game->projectiles[i].pos = p->pos;
-            Vector2 dir = Vector2Normalize(Vector2Subtract(target, p->pos));
-            float angle = GetRandomValue(-5, 5) * DEG2RAD;
-            game->projectiles[i].vel = Vector2Scale(Vector2Rotate(dir, angle), 350.0f);
-            game->projectiles[i].owner_id = p->id;
-            game->projectiles[i].lifetime = 0.0f;
-            game->projectiles[i].active = true;
-            game->projectiles[i].type = BULLET;
-            game->projectiles[i].damage = 30.0f;
-            game->projectiles[i].distance = 0.0f;
-            game->projectiles[i].max_distance = 320.0f;
-            police_cooldown[p->id] = 2.5f;
-            break;
-        }
+// Takes over the loaded music and synthesizes the effects. Called once the
+// asset loader is done; until then, and if this fails, the game is silent.
+bool StartAudioSystem(AudioSystem *audio)
+{
+    if (!IsAudioDeviceReady()) return false;
+    if (audio->music.stream.buffer != NULL) SetMusicVolume(audio->music, 0.5f);
+    for (int e = 0; e < SFX_COUNT; e++) {
+        Wave wave = SynthesizeEffect((SoundEffect)e);
+        if (wave.data != NULL) audio->effects[e] = LoadSoundFromWave(wave);
+        UnloadWave(wave);
+        for (int v = 0; v < AUDIO_MAX_VOICES; v++) audio->aliases[e][v] = LoadSoundAlias(audio->effects[e]);
+    }
+    for (int v = 0; v < AUDIO_MAX_VOICES; v++) audio->voices[v].effect = -1;
+
+    atomic_init(&audio->head, 0);
+    atomic_init(&audio->tail, 0);
+    atomic_init(&audio->requestedMusic, MUSIC_STOPPED);
+    atomic_init(&audio->stop, false);
+    pthread_mutex_init(&audio->lock, NULL);
+    pthread_cond_init(&audio->wake, NULL);
+    audio->running = (pthread_create(&audio->worker, NULL, AudioThread, audio) == 0);
+    if (!audio->running) {
+        TraceLog(LOG_WARNING, "AUDIO: Could not start audio thread");
+        pthread_mutex_destroy(&audio->lock);
+        pthread_cond_destroy(&audio->wake);
     }
+    return audio->running;
 }
 
-void HandleInput(GameState *game)
+void StopAudioSystem(AudioSystem *audio)
 {
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
-    {
-        game->isSelecting = true;
-        game->selectStart = GetMousePosition();
-        game->selectEnd = game->selectStart;
+    if (audio->running) {
+        pthread_mutex_lock(&audio->lock);
+        atomic_store(&audio->stop, true);
+        pthread_cond_signal(&audio->wake);
+        pthread_mutex_unlock(&audio->lock);
+        pthread_join(audio->worker, NULL);
+        pthread_mutex_destroy(&audio->lock);
+        pthread_cond_destroy(&audio->wake);
+        if (audio->dropped > 0) TraceLog(LOG_WARNING, "AUDIO: %u commands dropped", audio->dropped);
+        audio->running = false;
     }
-
-    if (game->isSelecting && IsMouseButtonDown(MOUSE_LEFT_BUTTON))
-    {
-        game->selectEnd = GetMousePosition();
+    for (int e = 0; e < SFX_COUNT; e++) {
+        if (audio->effects[e].frameCount == 0) continue;
+        for (int v = 0; v < AUDIO_MAX_VOICES; v++) UnloadSoundAlias(audio->aliases[e][v]);
+        UnloadSound(audio->effects[e]);
+        audio->effects[e] = (Sound){0};
     }
+    if (audio->music.stream.buffer != NULL) UnloadMusicStream(audio->music);
+    audio->music = (Music){0};
+}
 
-    if (game->isSelecting && IsMouseButtonReleased(MOUSE_LEFT_BUTTON))
-    {
-        float minX = fminf(game->selectStart.x, game->selectEnd.x);
-        float maxX = fmaxf(game->selectStart.x, game->selectEnd.x);
-        float minY = fminf(game->selectStart.y, game->selectEnd.y);
-        float maxY = fmaxf(game->selectStart.y, game->selectEnd.y);
+void SetMusicState(AudioSystem *audio, MusicState state)
+{
+    if (audio->running) atomic_store(&audio->requestedMusic, state);
+}
 
-        for (int i = 0; i < MAX_PROTESTERS; i++)
-        {
-            if (!game->protesters[i].alive)
-                continue;
-            Vector2 pos = game->protesters[i].pos;
-            game->selected[i] = (pos.x >= minX && pos.x <= maxX &&
-                                 pos.y >= minY && pos.y <= maxY);
+// Sounds are heard from the centre of the view and fade out AUDIO_RANGE
+// half-views away, so zooming out widens what is audible
+void SetAudioListener(AudioSystem *audio, Camera2D camera)
+{
+    float halfWidth = GetScreenWidth() * 0.5f / camera.zoom;
+    audio->listener = (Vector2){camera.target.x + halfWidth, camera.target.y + GetScreenHeight() * 0.5f / camera.zoom};
+    audio->reach = AUDIO_RANGE * halfWidth;
+}
+
+void PlayGameSound(GameState *game, SoundEffect effect, Vector2 pos)
+{
+    AudioSystem *audio = game->audio;
+    if (audio == NULL || !audio->running || audio->reach <= 0.0f) return;
+    float gain = 1.0f - Vector2Distance(pos, audio->listener) / audio->reach;
+    if (gain < AUDIO_MIN_GAIN) return;
+
+    AudioCommand command = {
+        .effect = (uint8_t)effect,
+        .volume = EFFECT_INFO[effect].volume * gain,
+        .pan = 0.5f + 0.5f * Clamp((pos.x - audio->listener.x) / audio->reach, -1.0f, 1.0f),
+        .priority = EFFECT_INFO[effect].priority * gain,
+    };
+    // Keep the frame's AUDIO_MAX_VOICES most important requests
+    int slot = audio->batchCount;
+    if (slot == AUDIO_MAX_VOICES) {
+        slot = 0;
+        for (int i = 1; i < AUDIO_MAX_VOICES; i++) {
+            if (audio->batch[i].priority < audio->batch[slot].priority) slot = i;
         }
-        game->isSelecting = false;
+        if (audio->batch[slot].priority >= command.priority) return;
+    } else {
+        audio->batchCount++;
     }
+    audio->batch[slot] = command;
+}
 
-    if (IsMouseButtonPressed(MOUSE_RIGHT_BUTTON))
-    {
-        Vector2 mousePos = GetMousePosition();
-        for (int i = 0; i < MAX_PROTESTERS; i++)
-        {
-            if (game->selected[i] && game->protesters[i].alive)
-            {
-                game->protesters[i].target_pos = mousePos;
-                switch (game->protesters[i].state)
-                {
-                case IDLE:
-                    game->protesters[i].state = CHANT;
-                    break;
-                case CHANT:
-                    game->protesters[i].state = RIOT;
-                    break;
-                case RIOT:
-                case FLEE:
-                    game->protesters[i].state = IDLE;
-                    break;
-                }
-                if (game->protesters[i].stoneCooldown <= 0.0f) {
-                    Vector2 dir = Vector2Subtract(mousePos, game->protesters[i].pos);
-                    FireStone(game, game->protesters[i].pos, dir, i);
-                    game->protesters[i].stoneCooldown = 0.2f;
-                }
-            }
+// Hands the frame's sound requests to the audio thread
+void FlushGameSounds(AudioSystem *audio)
+{
+    if (!audio->running || audio->batchCount == 0) return;
+    unsigned int head = atomic_load(&audio->head);
+    for (int i = 0; i < audio->batchCount; i++, head++) {
+        if (head - atomic_load(&audio->tail) >= AUDIO_QUEUE_SIZE) {
+            audio->dropped += (unsigned int)(audio->batchCount - i);
+            break;
         }
+        audio->ring[head % AUDIO_QUEUE_SIZE] = audio->batch[i];
     }
+    atomic_store(&audio->head, head);
+    audio->batchCount = 0;
+    pthread_mutex_lock(&audio->lock);
+    pthread_cond_signal(&audio->wake);
+    pthread_mutex_unlock(&audio->lock);
+}
 
-    if (IsKeyPressed(KEY_A))
-    {
-        for (int i = 0; i < MAX_PROTESTERS; i++)
-        {
-            game->selected[i] = game->protesters[i].alive;
+// Size of one spectator snapshot for this game's pool capacities
+size_t SnapshotSize(const GameState *game)
+{
+    return sizeof(SpectatorMatch) +
+           sizeof(PackedProtester) * game->maxProtesters +
+           sizeof(WirePolice) * game->maxPolice +
+           sizeof(WireProjectile) * game->maxProjectiles +
+           sizeof(WireGas) * game->maxGas +
+           sizeof(WireHelicopter) +
+           sizeof(WireVehicle) * VEHICLE_CAPACITY;
+}
+
+// Flattens the visible world into the layout described in spectator.h.
+// Protesters come straight from the crowd mirror.
+void WriteSnapshot(const GameState *game, uint8_t *out)
+{
+    double now = game->time;
+    SpectatorMatch match = {
+        .morale = game->globalMorale,
+        .control = game->controlProgress,
+        .elapsed = (float)(now - game->gameStartTime),
+        .controlTime = (game->controlStartTime > 0) ? (float)(now - game->controlStartTime) : 0.0f,
+        .surgeLeft = game->policeSurgeActive ? (float)(game->policeSurgeEnd - now) : -1.0f,
+        .menuState = (uint32_t)game->menuState,
+        .protesterCount = (uint32_t)game->protesterCount,
+        .policeCount = (uint32_t)game->policeCount,
+        .arrested = (uint32_t)game->protesters_arrested
+    };
+    memcpy(out, &match, sizeof(match));
+    out += sizeof(match);
+
+    memcpy(out, game->crowd, sizeof(PackedProtester) * game->maxProtesters);
+    out += sizeof(PackedProtester) * game->maxProtesters;
+
+    for (int i = 0; i < game->maxPolice; i++, out += sizeof(WirePolice)) {
+        const Police *p = &game->police[i];
+        WirePolice wire = {0};
+        wire.x = QuantizeRange(p->pos.x, 0.0f, game->worldWidth);
+        wire.y = QuantizeRange(p->pos.y, FIELD_TOP, FIELD_BOTTOM);
+        wire.health = (uint8_t)Clamp(p->health, 0.0f, 100.0f);
+        wire.flags = (uint8_t)(p->state & PACKED_STATE_MASK);
+        if (p->alive) wire.flags |= PACKED_ALIVE;
+        if (p->face_right) wire.flags |= PACKED_FACE_RIGHT;
+        wire.anim_phase = p->anim_phase;
+        memcpy(out, &wire, sizeof(wire));
+    }
+    for (int i = 0; i < game->maxProjectiles; i++, out += sizeof(WireProjectile)) {
+        const Projectile *proj = &game->projectiles[i];
+        WireProjectile wire = {0};
+        if (proj->active) {
+            wire.x = QuantizeRange(proj->pos.x, 0.0f, game->worldWidth);
+            wire.y = QuantizeRange(proj->pos.y, 0.0f, WORLD_HEIGHT);
+            wire.flags = (uint8_t)(1 | (proj->type << 1));
         }
+        memcpy(out, &wire, sizeof(wire));
     }
-
-    if (IsKeyPressed(KEY_SPACE))
-    {
-        for (int i = 0; i < MAX_PROTESTERS; i++)
-        {
-            if (game->selected[i] && game->protesters[i].alive)
-            {
-                game->protesters[i].state = FLEE;
-                game->protesters[i].target_pos = (Vector2){50, game->protesters[i].pos.y};
-            }
+    for (int g = 0; g < game->maxGas; g++, out += sizeof(WireGas)) {
+        const TearGas *gas = &game->gas[g];
+        WireGas wire = {0};
+        if (gas->active) {
+            wire.x = QuantizeRange(gas->pos.x, 0.0f, game->worldWidth);
+            wire.y = QuantizeRange(gas->pos.y, 0.0f, WORLD_HEIGHT);
+            wire.radius = (uint16_t)Clamp(gas->radius * 16.0f, 0.0f, 65535.0f);
+            wire.active = 1;
         }
+        memcpy(out, &wire, sizeof(wire));
     }
-
-    if (IsKeyPressed(KEY_T)) {
-        Vector2 mousePos = GetMousePosition();
-        for (int i = 0; i < MAX_PROTESTERS; i++) {
-            if (game->selected[i] && game->protesters[i].alive) {
-                if (game->protesters[i].stoneCooldown <= 0.0f) {
-                    Vector2 dir = Vector2Subtract(mousePos, game->protesters[i].pos);
-                    FireStone(game, game->protesters[i].pos, dir, i);
-                    game->protesters[i].stoneCooldown = 0.2f;
-                }
-            }
+    WireHelicopter heli = {game->helicopter.pos.x, game->helicopter.pos.y, game->helicopter.active ? 1u : 0u};
+    memcpy(out, &heli, sizeof(heli));
+    out += sizeof(heli);
+    for (int i = 0; i < VEHICLE_CAPACITY; i++, out += sizeof(WireVehicle)) {
+        const Vehicle *v = &game->vehicles[i];
+        WireVehicle wire = {0};
+        if (v->active) {
+            wire.x = QuantizeRange(v->pos.x, -VEHICLE_OFFSCREEN, game->worldWidth + VEHICLE_OFFSCREEN);
+            wire.y = QuantizeRange(v->pos.y, FIELD_TOP, FIELD_BOTTOM);
+            wire.flags = (uint8_t)(1 | (v->parked ? 2 : 0) | (v->dir < 0.0f ? 4 : 0) | (v->kind << 3));
         }
+        memcpy(out, &wire, sizeof(wire));
     }
 }
 
-bool CheckWinCondition(GameState *game)
+// Counterpart of WriteSnapshot, used by the viewer
+void ReadSnapshot(GameState *game, const uint8_t *in)
 {
-    // Win if all police are defeated
-    if (game->policeCount == 0) {
-        return true;
+    double now = game->time;
+    SpectatorMatch match;
+    memcpy(&match, in, sizeof(match));
+    in += sizeof(match);
+    game->globalMorale = match.morale;
+    game->controlProgress = match.control;
+    game->gameStartTime = now - match.elapsed;
+    game->controlStartTime = (match.controlTime > 0.0f) ? now - match.controlTime : 0;
+    game->policeSurgeActive = (match.surgeLeft >= 0.0f);
+    game->policeSurgeEnd = now + match.surgeLeft;
+    game->menuState = (GameMenu)match.menuState;
+    game->protesterCount = (int)match.protesterCount;
+    game->policeCount = (int)match.policeCount;
+    game->protesters_arrested = (int)match.arrested;
+
+    memcpy(game->crowd, in, sizeof(PackedProtester) * game->maxProtesters);
+    in += sizeof(PackedProtester) * game->maxProtesters;
+    for (int i = 0; i < game->maxProtesters; i++) {
+        DecodeProtester(game->crowd[i], game->worldWidth, &game->protesters[i]);
     }
 
-    // Calculate territory control
-    int advancedProtesters = 0;
-    for (int i = 0; i < MAX_PROTESTERS; i++)
-    {
-        if (game->protesters[i].alive && game->protesters[i].pos.x > 800)
-        {
-            advancedProtesters++;
+    for (int i = 0; i < game->maxPolice; i++, in += sizeof(WirePolice)) {
+        Police *p = &game->police[i];
+        WirePolice wire;
+        memcpy(&wire, in, sizeof(wire));
+        p->pos = (Vector2){DequantizeRange(wire.x, 0.0f, game->worldWidth), DequantizeRange(wire.y, FIELD_TOP, FIELD_BOTTOM)};
+        p->health = wire.health;
+        p->state = (PoliceState)(wire.flags & PACKED_STATE_MASK);
+        p->alive = (wire.flags & PACKED_ALIVE) != 0;
+        p->face_right = (wire.flags & PACKED_FACE_RIGHT) != 0;
+        p->anim_phase = wire.anim_phase;
+    }
+    for (int i = 0; i < game->maxProjectiles; i++, in += sizeof(WireProjectile)) {
+        Projectile *proj = &game->projectiles[i];
+        WireProjectile wire;
+        memcpy(&wire, in, sizeof(wire));
+        proj->active = (wire.flags & 1) != 0;
+        proj->type = (ProjectileType)((wire.flags >> 1) & 3);
+        proj->pos = (Vector2){DequantizeRange(wire.x, 0.0f, game->worldWidth), DequantizeRange(wire.y, 0.0f, WORLD_HEIGHT)};
+    }
+    for (int g = 0; g < game->maxGas; g++, in += sizeof(WireGas)) {
+        TearGas *gas = &game->gas[g];
+        WireGas wire;
+        memcpy(&wire, in, sizeof(wire));
+        gas->active = wire.active != 0;
+        gas->pos = (Vector2){DequantizeRange(wire.x, 0.0f, game->worldWidth), DequantizeRange(wire.y, 0.0f, WORLD_HEIGHT)};
+        gas->radius = wire.radius / 16.0f;
+    }
+    WireHelicopter heli;
+    memcpy(&heli, in, sizeof(heli));
+    game->helicopter.pos = (Vector2){heli.x, heli.y};
+    game->helicopter.active = heli.active != 0;
+    in += sizeof(heli);
+    for (int i = 0; i < VEHICLE_CAPACITY; i++, in += sizeof(WireVehicle)) {
+        Vehicle *v = &game->vehicles[i];
+        WireVehicle wire;
+        memcpy(&wire, in, sizeof(wire));
+        v->active = (wire.flags & 1) != 0;
+        v->parked = (wire.flags & 2) != 0;
+        v->dir = (wire.flags & 4) ? -1.0f : 1.0f;
+        v->kind = (VehicleKind)((wire.flags >> 3) & 3);
+        v->pos = (Vector2){DequantizeRange(wire.x, -VEHICLE_OFFSCREEN, game->worldWidth + VEHICLE_OFFSCREEN), DequantizeRange(wire.y, FIELD_TOP, FIELD_BOTTOM)};
+    }
+}
+
+// Worst-case encoded size of a snapshot delta
+size_t SnapshotDeltaBound(size_t size)
+{
+    return size + size / 4 + 32;
+}
+
+static size_t WriteVarint(uint8_t *out, size_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool ReadVarint(const uint8_t **in, const uint8_t *end, size_t *value)
+{
+    size_t result = 0;
+    for (int shift = 0; *in < end && shift < 64; shift += 7) {
+        uint8_t byte = *(*in)++;
+        result |= (size_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
         }
     }
+    return false;
+}
 
-    float controlPercentage = game->protesterCount > 0 ? (float)advancedProtesters / game->protesterCount : 0.0f;
+// Encodes `current` against `base` (NULL for a keyframe, i.e. a zero base)
+// as runs of [varint bytes unchanged][varint bytes changed][changed ^ base].
+// Unchanged gaps shorter than 4 bytes are folded into the changed run,
+// where they cost less than a new run header. Trailing unchanged bytes are
+// omitted.
+size_t EncodeSnapshotDelta(const uint8_t *base, const uint8_t *current, size_t size, uint8_t *out)
+{
+    size_t pos = 0;
+    size_t written = 0;
+    while (pos < size) {
+        size_t start = pos;
+        while (pos < size && current[pos] == (base ? base[pos] : 0)) pos++;
+        if (pos == size) break;
 
-    // Lowered threshold for morale and control percentage to make winning more achievable
-    if (game->globalMorale > 60.0f && controlPercentage > 0.5f)
-    {
-        if (game->controlStartTime == 0)
-        {
-            game->controlStartTime = GetTime();
+        size_t lastChanged = pos;
+        for (size_t j = pos; j < size && j - lastChanged < 4; j++) {
+            if (current[j] != (base ? base[j] : 0)) lastChanged = j;
         }
-        else if (GetTime() - game->controlStartTime > 10.0f) // Reduced time to hold control
-        {
-            return true;
+        written += WriteVarint(out + written, pos - start);
+        written += WriteVarint(out + written, lastChanged + 1 - pos);
+        for (; pos <= lastChanged; pos++) {
+            out[written++] = current[pos] ^ (base ? base[pos] : 0);
         }
     }
-    else
-    {
-        game->controlStartTime = 0;
+    return written;
+}
+
+// Rebuilds a snapshot from its base and a delta; false if the delta is
+// malformed or does not fit. `out` may be the base itself.
+bool DecodeSnapshotDelta(const uint8_t *base, const uint8_t *delta, size_t deltaSize, uint8_t *out, size_t size)
+{
+    if (base == NULL) memset(out, 0, size);
+    else if (base != out) memcpy(out, base, size);
+
+    const uint8_t *in = delta;
+    const uint8_t *end = delta + deltaSize;
+    size_t pos = 0;
+    while (in < end) {
+        size_t skip, count;
+        if (!ReadVarint(&in, end, &skip) || !ReadVarint(&in, end, &count)) return false;
+        if (skip > size - pos || count > size - pos - skip || count > (size_t)(end - in)) return false;
+        pos += skip;
+        for (size_t i = 0; i < count; i++) out[pos++] ^= *in++;
     }
+    return true;
+}
 
-    return false;
+#ifndef SPECTATOR_VIEWER
+typedef struct
+{
+    PlatformSocket socket;
+    uint32_t ackedTick;
+    uint32_t keyframeTick;
+    uint8_t *outbox; // one message at a time; a slow viewer just skips ticks
+    size_t outboxSize;
+    size_t outboxSent;
+    uint8_t inbox[sizeof(SpectatorMessage)];
+    size_t inboxSize;
+} SpectatorClient;
+
+// Streams snapshots to local viewers from its own thread. The game thread
+// only writes a snapshot into a spare buffer and swaps it in; diffing,
+// compression and socket I/O all happen on the server thread.
+typedef struct
+{
+    PlatformSocket listener;
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    atomic_bool stop;
+    atomic_int clientCount;
+    bool running;
+    SpectatorHello hello;
+    size_t snapshotSize;
+    uint8_t *back;        // game thread fills this
+    uint8_t *pending;     // latest published snapshot, guarded by lock
+    uint8_t *front;       // being sent by the server thread
+    uint32_t tick;        // last tick published by the game thread
+    uint32_t pendingTick; // guarded by lock
+    uint32_t frontTick;
+    uint8_t *history[SPECTATOR_HISTORY];
+    uint32_t historyTick[SPECTATOR_HISTORY];
+    SpectatorClient clients[SPECTATOR_MAX_CLIENTS];
+} SpectatorServer;
+
+static void QueueSpectatorMessage(SpectatorClient *client, SpectatorMessageType type, uint32_t tick,
+                                  uint32_t baseTick, const void *payload, size_t payloadSize)
+{
+    SpectatorMessage header = {SPECTATOR_MAGIC, (uint32_t)type, tick, baseTick, (uint32_t)payloadSize};
+    memcpy(client->outbox, &header, sizeof(header));
+    if (payload != NULL) memcpy(client->outbox + sizeof(header), payload, payloadSize);
+    client->outboxSize = sizeof(header) + payloadSize;
+    client->outboxSent = 0;
 }
 
-bool CheckLoseCondition(GameState *game)
+static void DropSpectatorClient(SpectatorServer *server, SpectatorClient *client)
 {
-    double elapsed = GetTime() - game->gameStartTime;
-    return (game->globalMorale < 10.0f ||
-            game->protesterCount < 20 ||
-            elapsed > GAME_DURATION);
+    PlatformCloseSocket(client->socket);
+    free(client->outbox);
+    memset(client, 0, sizeof(SpectatorClient));
+    client->socket = PLATFORM_INVALID_SOCKET;
+    atomic_fetch_sub(&server->clientCount, 1);
+    TraceLog(LOG_INFO, "SPECTATOR: Viewer disconnected");
 }
 
-void UpdateGame(GameState *game)
+static void ServiceSpectatorClients(SpectatorServer *server)
 {
-    if (game->menuState != MENU_PLAY)
-        return;
+    PlatformSocket incoming;
+    while ((incoming = PlatformAccept(server->listener)) != PLATFORM_INVALID_SOCKET) {
+        SpectatorClient *client = NULL;
+        for (int c = 0; c < SPECTATOR_MAX_CLIENTS && client == NULL; c++) {
+            if (server->clients[c].socket == PLATFORM_INVALID_SOCKET) client = &server->clients[c];
+        }
+        uint8_t *outbox = (client != NULL) ? malloc(sizeof(SpectatorMessage) + SnapshotDeltaBound(server->snapshotSize)) : NULL;
+        if (outbox == NULL) {
+            TraceLog(LOG_WARNING, "SPECTATOR: Refusing viewer, no free slot");
+            PlatformCloseSocket(incoming);
+            continue;
+        }
+        client->socket = incoming;
+        client->outbox = outbox;
+        QueueSpectatorMessage(client, SPECTATOR_HELLO, 0, 0, &server->hello, sizeof(server->hello));
+        atomic_fetch_add(&server->clientCount, 1);
+        TraceLog(LOG_INFO, "SPECTATOR: Viewer connected");
+    }
 
-    HandleInput(game);
-    UpdateProtesters(game);
-    UpdatePolice(game);
-    UpdateTearGas(game);
-    UpdateHelicopter(game, GetFrameTime());
+    for (int c = 0; c < SPECTATOR_MAX_CLIENTS; c++) {
+        SpectatorClient *client = &server->clients[c];
+        if (client->socket == PLATFORM_INVALID_SOCKET) continue;
 
-    double now = GetTime();
-    if (now - game->policeSurgeTimer > 45.0 && !game->policeSurgeActive)
-    {
-        game->policeSurgeActive = true;
-        game->policeSurgeEnd = now + 15.0;
-        for (int i = 0; i < MAX_POLICE; i++)
-        {
-            if (game->police[i].alive)
-            {
-                game->police[i].state = INTERVENE;
+        long received;
+        while ((received = PlatformRecv(client->socket, client->inbox + client->inboxSize,
+                                        sizeof(client->inbox) - client->inboxSize)) > 0) {
+            client->inboxSize += (size_t)received;
+            if (client->inboxSize < sizeof(SpectatorMessage)) continue;
+            SpectatorMessage ack;
+            memcpy(&ack, client->inbox, sizeof(ack));
+            client->inboxSize = 0;
+            if (ack.magic != SPECTATOR_MAGIC || ack.type != SPECTATOR_ACK) {
+                received = -1;
+                break;
             }
+            if (ack.tick > client->ackedTick) client->ackedTick = ack.tick;
+        }
+        if (received < 0) {
+            DropSpectatorClient(server, client);
+            continue;
         }
-    }
 
-    if (game->policeSurgeActive && now > game->policeSurgeEnd)
-    {
-        game->policeSurgeActive = false;
-        game->policeSurgeTimer = now;
-        for (int i = 0; i < MAX_POLICE; i++)
-        {
-            if (game->police[i].alive)
-            {
-                game->police[i].state = PATROL;
+        while (client->outboxSent < client->outboxSize) {
+            long sent = PlatformSend(client->socket, client->outbox + client->outboxSent,
+                                     client->outboxSize - client->outboxSent);
+            if (sent <= 0) {
+                if (sent < 0) DropSpectatorClient(server, client);
+                break;
             }
+            client->outboxSent += (size_t)sent;
         }
     }
+}
 
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        Projectile *proj = &game->projectiles[i];
-        if (!proj->active) continue;
-        float moveStep = Vector2Length(proj->vel) * GetFrameTime();
-        proj->pos = Vector2Add(proj->pos, Vector2Scale(proj->vel, GetFrameTime()));
-        proj->distance += moveStep;
-        proj->lifetime += GetFrameTime();
-        if (proj->distance > proj->max_distance || proj->lifetime > 2.0f ||
-            proj->pos.x < 0 || proj->pos.x > 1600 ||
-            proj->pos.y < 0 || proj->pos.y > 900) {
-            proj->active = false;
-            continue;
+// Queues the front snapshot for every viewer that has finished receiving
+// its previous message, as a delta against the newest snapshot it acked
+static void BroadcastSnapshot(SpectatorServer *server)
+{
+    int slot = server->frontTick % SPECTATOR_HISTORY;
+    memcpy(server->history[slot], server->front, server->snapshotSize);
+    server->historyTick[slot] = server->frontTick;
+
+    for (int c = 0; c < SPECTATOR_MAX_CLIENTS; c++) {
+        SpectatorClient *client = &server->clients[c];
+        if (client->socket == PLATFORM_INVALID_SOCKET || client->outboxSent < client->outboxSize) continue;
+
+        const uint8_t *base = NULL;
+        uint32_t baseTick = 0;
+        int baseSlot = client->ackedTick % SPECTATOR_HISTORY;
+        if (client->ackedTick != 0 && server->historyTick[baseSlot] == client->ackedTick &&
+            server->frontTick - client->keyframeTick < SPECTATOR_KEYFRAME_INTERVAL) {
+            base = server->history[baseSlot];
+            baseTick = client->ackedTick;
+        } else {
+            client->keyframeTick = server->frontTick;
         }
-        if (proj->type == HELICOPTER_BULLET) {
-            for (int j = 0; j < MAX_PROTESTERS; j++) {
-                Protester *pr = &game->protesters[j];
-                if (pr->alive && Vector2Distance(proj->pos, pr->pos) < 8.0f) {
-                    pr->morale -= proj->damage;
-                    if (pr->morale <= 0) {
-                        pr->alive = false;
-                        game->globalMorale -= 10.0f;
-                    }
-                    proj->active = false;
-                    break;
-                }
-            }
-        } else if (proj->type == BULLET) {
-            for (int j = 0; j < MAX_PROTESTERS; j++) {
-                Protester *pr = &game->protesters[j];
-                if (pr->alive && Vector2Distance(proj->pos, pr->pos) < 8.0f) {
-                    pr->morale -= proj->damage;
-                    if (pr->morale <= 0) {
-                        pr->alive = false;
-                        game->globalMorale -= 5.0f;
-                    }
-                    proj->active = false;
-                    break;
-                }
-            }
-        } else if (proj->type == STONE) {
-            for (int j = 0; j < MAX_POLICE; j++) {
-                Police *pol = &game->police[j];
-                if (!pol->alive) continue;
-                float dist = Vector2Distance(proj->pos, pol->pos);
-                if (dist < 24.0f) {
-                    pol->health -= proj->damage;
-                    pol->vel = Vector2Add(pol->vel, Vector2Scale(proj->vel, 0.5f));
-                    proj->active = false;
-                    game->globalMorale += 2.0f;
-                    if (pol->health <= 0.0f) {
-                        pol->alive = false;
-                    }
-                    break;
-                }
+        uint8_t *payload = client->outbox + sizeof(SpectatorMessage);
+        size_t payloadSize = EncodeSnapshotDelta(base, server->front, server->snapshotSize, payload);
+        QueueSpectatorMessage(client, SPECTATOR_DELTA, server->frontTick, baseTick, NULL, payloadSize);
+    }
+}
+
+void *SpectatorServerThread(void *arg)
+{
+    SpectatorServer *server = (SpectatorServer *)arg;
+    while (!atomic_load(&server->stop)) {
+        ServiceSpectatorClients(server);
+
+        // Wake for new snapshots, or every few milliseconds to poll sockets
+        pthread_mutex_lock(&server->lock);
+        if (server->pendingTick == server->frontTick && !atomic_load(&server->stop)) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 5 * 1000000;
+            if (deadline.tv_nsec >= 1000000000) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
             }
+            pthread_cond_timedwait(&server->wake, &server->lock, &deadline);
+        }
+        bool fresh = (server->pendingTick != server->frontTick);
+        if (fresh) {
+            uint8_t *swap = server->front;
+            server->front = server->pending;
+            server->pending = swap;
+            server->frontTick = server->pendingTick;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        if (fresh) {
+            BroadcastSnapshot(server);
+            ServiceSpectatorClients(server);
         }
     }
+    return NULL;
+}
+
+bool StartSpectatorServer(SpectatorServer *server, const GameState *game)
+{
+    const ScenarioConfig *scenario = &game->scenario;
+    memset(server, 0, sizeof(SpectatorServer));
+    server->listener = PLATFORM_INVALID_SOCKET;
+    if (scenario->spectatorPort == 0) return false;
+
+    server->snapshotSize = SnapshotSize(game);
+    server->hello = (SpectatorHello){
+        (uint32_t)game->maxProtesters, (uint32_t)game->maxPolice, (uint32_t)game->maxProjectiles,
+        (uint32_t)game->maxGas, (uint32_t)scenario->worldWidth
+    };
+    for (int c = 0; c < SPECTATOR_MAX_CLIENTS; c++) server->clients[c].socket = PLATFORM_INVALID_SOCKET;
 
-    for (int i = 0; i < POLICE_COUNT; i++) {
-        if (police_cooldown[i] > 0) police_cooldown[i] -= GetFrameTime();
+    // All snapshot buffers in one block: back, pending, front, then history
+    uint8_t *buffers = calloc(3 + SPECTATOR_HISTORY, server->snapshotSize);
+    if (buffers == NULL || !PlatformSocketsInit()) {
+        TraceLog(LOG_WARNING, "SPECTATOR: Could not start server");
+        free(buffers);
+        return false;
     }
+    server->back = buffers;
+    server->pending = buffers + server->snapshotSize;
+    server->front = buffers + 2 * server->snapshotSize;
+    for (int h = 0; h < SPECTATOR_HISTORY; h++) server->history[h] = buffers + (3 + h) * server->snapshotSize;
 
-    if (CheckWinCondition(game))
-    {
-        game->menuState = MENU_WIN;
+    server->listener = PlatformListenLoopback(scenario->spectatorPort);
+    if (server->listener == PLATFORM_INVALID_SOCKET) {
+        TraceLog(LOG_WARNING, "SPECTATOR: Could not listen on port %d", scenario->spectatorPort);
+        PlatformSocketsShutdown();
+        free(buffers);
+        return false;
     }
-    else if (CheckLoseCondition(game))
-    {
-        game->menuState = MENU_LOSE;
+    atomic_init(&server->stop, false);
+    atomic_init(&server->clientCount, 0);
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->wake, NULL);
+    server->running = (pthread_create(&server->worker, NULL, SpectatorServerThread, server) == 0);
+    if (!server->running) {
+        TraceLog(LOG_WARNING, "SPECTATOR: Could not start server thread");
+        pthread_mutex_destroy(&server->lock);
+        pthread_cond_destroy(&server->wake);
+        PlatformCloseSocket(server->listener);
+        PlatformSocketsShutdown();
+        free(buffers);
+        return false;
     }
+    TraceLog(LOG_INFO, "SPECTATOR: Streaming on 127.0.0.1:%d (%zu byte snapshots)", scenario->spectatorPort, server->snapshotSize);
+    return true;
 }
 
-typedef struct {
-    float y;
-    int type; // 1 = protester, 2 = police
-    int index;
-} DrawEntity;
+// Hands this frame's state to the server thread; free when nobody watches
+void PublishSpectatorState(SpectatorServer *server, const GameState *game)
+{
+    if (!server->running || atomic_load(&server->clientCount) == 0) return;
+    WriteSnapshot(game, server->back);
+    pthread_mutex_lock(&server->lock);
+    uint8_t *swap = server->pending;
+    server->pending = server->back;
+    server->back = swap;
+    server->pendingTick = ++server->tick;
+    pthread_cond_signal(&server->wake);
+    pthread_mutex_unlock(&server->lock);
+}
 
-void DrawGame(GameState *game, Font pixelFont, Texture2D *textures)
+void StopSpectatorServer(SpectatorServer *server)
 {
-    int screenWidth = GetScreenWidth();
-    int screenHeight = GetScreenHeight();
-    DrawEntity drawList[MAX_PROTESTERS + MAX_POLICE];
-    int drawCount = 0;
+    if (!server->running) return;
+    pthread_mutex_lock(&server->lock);
+    atomic_store(&server->stop, true);
+    pthread_cond_signal(&server->wake);
+    pthread_mutex_unlock(&server->lock);
+    pthread_join(server->worker, NULL);
+    for (int c = 0; c < SPECTATOR_MAX_CLIENTS; c++) {
+        if (server->clients[c].socket != PLATFORM_INVALID_SOCKET) DropSpectatorClient(server, &server->clients[c]);
+    }
+    PlatformCloseSocket(server->listener);
+    PlatformSocketsShutdown();
+    pthread_mutex_destroy(&server->lock);
+    pthread_cond_destroy(&server->wake);
+    // back, pending and front rotate, so free the block from its lowest address
+    uint8_t *block = server->back;
+    if (server->pending < block) block = server->pending;
+    if (server->front < block) block = server->front;
+    free(block);
+    server->running = false;
+}
 
-    for (int i = 0; i < MAX_PROTESTERS; i++) {
-        if (game->protesters[i].alive) {
-            drawList[drawCount].y = game->protesters[i].pos.y;
-            drawList[drawCount].type = 1;
-            drawList[drawCount].index = i;
-            drawCount++;
-        }
+// Rolling history of whole match states for rewinding. A capture is the
+// GameState struct followed by the pool arena, which holds every entity,
+// the squads and the timer wheel; timers link by index, so the bytes are
+// valid wherever they are copied back. Each capture is delta-encoded against
+// the one before it (EncodeSnapshotDelta) with a keyframe every
+// REWIND_KEYFRAME_INTERVAL captures, into a byte ring of REWIND_MEMORY bytes.
+// The oldest keyframe and its deltas are dropped together when space runs
+// out.
+typedef struct
+{
+    size_t offset; // into data
+    size_t size;   // encoded bytes
+    double time;   // game->time when captured
+    bool keyframe;
+} RewindEntry;
+
+typedef struct
+{
+    uint8_t *data;
+    size_t capacity;
+    size_t head;     // where the next capture is written
+    size_t stateSize;
+    uint8_t *previous; // the newest capture, decoded: the next delta's base
+    uint8_t *current;  // scratch for the capture being encoded
+    uint8_t *view;     // the capture at viewIndex while scrubbing, decoded
+    RewindEntry entries[REWIND_MAX_ENTRIES];
+    int first;         // oldest entry
+    int count;
+    int sinceKeyframe;
+    int viewIndex;     // 0 is the oldest entry, -1 when view is stale
+    double lastCapture;
+} RewindBuffer;
+
+static size_t MatchStateSize(const GameState *game)
+{
+    return sizeof(GameState) + game->poolArena.used;
+}
+
+static void WriteMatchState(const GameState *game, uint8_t *out)
+{
+    memcpy(out, game, sizeof(GameState));
+    memcpy(out + sizeof(GameState), game->poolArena.base, game->poolArena.used);
+}
+
+// Puts the match back as captured. What belongs to the session rather than
+// the match (camera, input, menu, subsystems, memory, texture handles) is
+// kept as it is now.
+static void ReadMatchState(GameState *game, const uint8_t *in)
+{
+    GameState live = *game;
+    memcpy(game, in, sizeof(GameState));
+    memcpy(live.poolArena.base, in + sizeof(GameState), live.poolArena.used);
+    game->inputSource = live.inputSource;
+    game->input = live.input;
+    game->workers = live.workers;
+    game->audio = live.audio;
+    game->particles = live.particles;
+    game->camera = live.camera;
+    game->poolArena = live.poolArena;
+    game->frameArena = live.frameArena;
+    game->animTime = live.animTime;
+    memcpy(game->systemTime, live.systemTime, sizeof(game->systemTime));
+    game->timedTicks = live.timedTicks;
+    game->events = live.events;
+    game->isSelecting = false;
+    game->menuState = live.menuState;
+    game->helicopter.sprite = live.helicopter.sprite;
+}
+
+bool InitRewindBuffer(RewindBuffer *rewind, const GameState *game)
+{
+    memset(rewind, 0, sizeof(RewindBuffer));
+    rewind->stateSize = MatchStateSize(game);
+    rewind->capacity = REWIND_MEMORY;
+    if (rewind->capacity < 2 * SnapshotDeltaBound(rewind->stateSize)) {
+        rewind->capacity = 2 * SnapshotDeltaBound(rewind->stateSize);
     }
+    uint8_t *block = malloc(rewind->capacity + 3 * rewind->stateSize);
+    if (block == NULL) {
+        TraceLog(LOG_WARNING, "REWIND: Could not allocate history, rewinding is off");
+        rewind->capacity = 0;
+        return false;
+    }
+    rewind->data = block;
+    rewind->previous = block + rewind->capacity;
+    rewind->current = rewind->previous + rewind->stateSize;
+    rewind->view = rewind->current + rewind->stateSize;
+    rewind->viewIndex = -1;
+    rewind->lastCapture = -1.0;
+    return true;
+}
 
-    for (int i = 0; i < MAX_POLICE; i++) {
-        if (game->police[i].alive) {
-            drawList[drawCount].y = game->police[i].pos.y;
-            drawList[drawCount].type = 2;
-            drawList[drawCount].index = i;
-            drawCount++;
+// Forgets the history, so a new match cannot be rewound into the last one
+void ClearRewindBuffer(RewindBuffer *rewind)
+{
+    rewind->first = 0;
+    rewind->count = 0;
+    rewind->head = 0;
+    rewind->sinceKeyframe = 0;
+    rewind->viewIndex = -1;
+    rewind->lastCapture = -1.0;
+}
+
+void UnloadRewindBuffer(RewindBuffer *rewind)
+{
+    free(rewind->data);
+    memset(rewind, 0, sizeof(RewindBuffer));
+}
+
+static RewindEntry *RewindEntryAt(RewindBuffer *rewind, int index)
+{
+    return &rewind->entries[(rewind->first + index) % REWIND_MAX_ENTRIES];
+}
+
+// Drops the oldest keyframe together with the deltas that depend on it
+static void DropOldestRewindGroup(RewindBuffer *rewind)
+{
+    do {
+        rewind->first = (rewind->first + 1) % REWIND_MAX_ENTRIES;
+        rewind->count--;
+    } while (rewind->count > 0 && !RewindEntryAt(rewind, 0)->keyframe);
+    rewind->viewIndex = -1;
+}
+
+// Offset of `need` contiguous free bytes, dropping history to make room.
+// Every entry spans at least one byte, so while entries exist the ring has
+// wrapped exactly when head is at or before the oldest one.
+static size_t ReserveRewindSpace(RewindBuffer *rewind, size_t need)
+{
+    while (rewind->count > 0) {
+        size_t tail = RewindEntryAt(rewind, 0)->offset;
+        if (rewind->head > tail) {
+            if (rewind->capacity - rewind->head >= need) return rewind->head;
+            if (tail >= need) return 0;
+        } else if (tail - rewind->head >= need) {
+            return rewind->head;
         }
+        DropOldestRewindGroup(rewind);
     }
+    return 0;
+}
 
-    if (textures[6].id != 0) {
-        Rectangle src = {0, 0, (float)textures[6].width, (float)textures[6].height};
-        Rectangle dest = {0, 0, (float)screenWidth, (float)screenHeight};
-        DrawTexturePro(textures[6], src, dest, (Vector2){0, 0}, 0.0f, WHITE);
-    }
+// Records the match every REWIND_INTERVAL seconds of play; `force` records
+// it now regardless
+void CaptureRewind(RewindBuffer *rewind, const GameState *game, bool force)
+{
+    if (rewind->capacity == 0) return;
+    if (!force && rewind->count > 0 && game->time - rewind->lastCapture < REWIND_INTERVAL) return;
+    if (rewind->count > 0 && game->time == rewind->lastCapture) return;
 
-    DrawHelicopter(game, textures[9]);
+    WriteMatchState(game, rewind->current);
+    if (rewind->count == REWIND_MAX_ENTRIES) DropOldestRewindGroup(rewind);
+    size_t offset = ReserveRewindSpace(rewind, SnapshotDeltaBound(rewind->stateSize));
+    bool keyframe = rewind->count == 0 || rewind->sinceKeyframe >= REWIND_KEYFRAME_INTERVAL;
+    size_t size = EncodeSnapshotDelta(keyframe ? NULL : rewind->previous, rewind->current, rewind->stateSize,
+                                      rewind->data + offset);
 
-    for (int i = 1; i < drawCount; i++) {
-        DrawEntity key = drawList[i];
-        int j = i - 1;
-        while (j >= 0 && drawList[j].y > key.y) {
-            drawList[j + 1] = drawList[j];
-            j = j - 1;
+    RewindEntry *entry = RewindEntryAt(rewind, rewind->count++);
+    *entry = (RewindEntry){offset, size, game->time, keyframe};
+    rewind->head = offset + (size > 0 ? size : 1);
+    rewind->sinceKeyframe = keyframe ? 1 : rewind->sinceKeyframe + 1;
+    rewind->lastCapture = game->time;
+
+    uint8_t *swap = rewind->previous;
+    rewind->previous = rewind->current;
+    rewind->current = swap;
+}
+
+// Decodes entry `index` into view, starting from its keyframe or, when
+// stepping forward within the same group, from the entry shown now
+static bool DecodeRewindEntry(RewindBuffer *rewind, int index)
+{
+    int from = index;
+    while (from > 0 && !RewindEntryAt(rewind, from)->keyframe) from--;
+    if (rewind->viewIndex >= from && rewind->viewIndex <= index) from = rewind->viewIndex + 1;
+    for (int i = from; i <= index; i++) {
+        const RewindEntry *entry = RewindEntryAt(rewind, i);
+        if (!DecodeSnapshotDelta(entry->keyframe ? NULL : rewind->view, rewind->data + entry->offset, entry->size,
+                                 rewind->view, rewind->stateSize)) {
+            rewind->viewIndex = -1;
+            return false;
         }
-        drawList[j + 1] = key;
     }
+    rewind->viewIndex = index;
+    return true;
+}
 
-    for (int i = 0; i < drawCount; i++) {
-        DrawEntity entity = drawList[i];
-        switch (entity.type) {
-        case 1: {
-            Protester *p = &game->protesters[entity.index];
-            Texture2D anim_sprite = (p->state == RIOT || p->state == FLEE) ? p->run_sprites[p->anim_frame] : p->sprites[p->anim_frame];
-            Vector2 pos = (Vector2){p->pos.x - anim_sprite.width/2, p->pos.y - anim_sprite.height/2};
-            Color tint = WHITE;
-            switch (p->state) {
-                case CHANT: tint = SKYBLUE; break;
-                case RIOT: tint = ORANGE; break;
-                case FLEE: tint = PINK; break;
-                case IDLE:
-                default: tint = WHITE; break;
-            }
-            if (anim_sprite.id != 0) {
-                DrawTextureV(anim_sprite, pos, tint);
-            } else {
-                DrawCircleV(p->pos, 8, tint);
-            }
-            if (game->selected[entity.index]) {
-                DrawRectangleLines((int)pos.x, (int)pos.y, 39, 69, BLUE);
-                DrawCircleLines((int)p->pos.x, (int)p->pos.y, 18, BLUE);
-            }
-            if (p->state == CHANT) {
-                const char *slogans[] = {
-                    "Tumi ke ami ke",
-                    "Quota na medha",
-                    "Medha!!",
-                    "Odhikar chai",
-                    "Nyay chai"};
-                int sloganIdx = entity.index % 5;
-                Vector2 bubblePos = {p->pos.x - 30, p->pos.y - 35};
-                int textWidth = MeasureText(slogans[sloganIdx], 12);
-                DrawRectangle((int)bubblePos.x, (int)bubblePos.y, textWidth + 10, 20, WHITE);
-                DrawRectangleLines((int)bubblePos.x, (int)bubblePos.y, textWidth + 10, 20, DARKBLUE);
-                DrawTextEx(pixelFont, slogans[sloganIdx], (Vector2){bubblePos.x + 5, bubblePos.y + 4}, 12, 1, DARKBLUE);
-            }
-            if (game->selected[entity.index]) {
-                DrawRectangle((int)(p->pos.x - 8), (int)(p->pos.y + 10), 16, 3, RED);
-                DrawRectangle((int)(p->pos.x - 8), (int)(p->pos.y + 10), (int)(16 * p->morale / 100.0f), 3, GREEN);
-            }
-            break;
-        }
-        case 2: {
-            Police *p = &game->police[entity.index];
-            Texture2D anim_sprite = (p->state == INTERVENE || p->state == DEPLOY) ? p->run_sprites[p->anim_frame] : p->sprites[p->anim_frame];
-            Vector2 pos = (Vector2){p->pos.x - anim_sprite.width/2, p->pos.y - anim_sprite.height/2};
-            Color tint = WHITE;
-            if (p->state == INTERVENE || p->state == DEPLOY) {
-                tint = RED;
-            } else if (p->state == PATROL) {
-                tint = LIGHTGRAY;
-            }
-            if (anim_sprite.id != 0) {
-                DrawTextureV(anim_sprite, pos, tint);
-            } else {
-                DrawCircleV(p->pos, 8, tint);
-            }
-            if (p->state == DEPLOY) {
-                DrawCircleLines((int)p->pos.x, (int)p->pos.y, 20, YELLOW);
-            } else if (p->state == INTERVENE) {
-                DrawCircleLines((int)p->pos.x, (int)p->pos.y, 15, RED);
-            }
-            break;
-        }
-        }
+// Shows capture `index` (0 is the oldest). The match stays paused there until
+// ResumeFromRewind.
+bool SeekRewind(RewindBuffer *rewind, GameState *game, int index)
+{
+    if (rewind->count == 0) return false;
+    index = (index < 0) ? 0 : (index >= rewind->count) ? rewind->count - 1 : index;
+    if (index == rewind->viewIndex) return true;
+    if (!DecodeRewindEntry(rewind, index)) {
+        TraceLog(LOG_WARNING, "REWIND: Capture %d is corrupt", index);
+        return false;
     }
+    ReadMatchState(game, rewind->view);
+    return true;
+}
 
-    for (int g = 0; g < MAX_GAS; g++) {
-        if (game->gas[g].active) {
-            DrawCircleV(game->gas[g].pos, game->gas[g].radius, Fade(YELLOW, 0.5f));
+// Continues the match from the capture being shown; the history after it is
+// discarded, since play now diverges from it
+void ResumeFromRewind(RewindBuffer *rewind)
+{
+    if (rewind->viewIndex < 0) return;
+    rewind->count = rewind->viewIndex + 1;
+    const RewindEntry *newest = RewindEntryAt(rewind, rewind->viewIndex);
+    rewind->head = newest->offset + (newest->size > 0 ? newest->size : 1);
+    rewind->lastCapture = newest->time;
+    rewind->sinceKeyframe = 0;
+    for (int i = rewind->viewIndex; i >= 0 && !RewindEntryAt(rewind, i)->keyframe; i--) rewind->sinceKeyframe++;
+    rewind->sinceKeyframe++;
+    memcpy(rewind->previous, rewind->view, rewind->stateSize);
+}
+
+// Timeline along the top of the screen while scrubbing
+void DrawRewindBar(RewindBuffer *rewind, Font font)
+{
+    if (rewind->count == 0 || rewind->viewIndex < 0) return;
+    int width = GetScreenWidth() - 200;
+    Rectangle bar = {100, 24, (float)width, 12};
+    double oldest = RewindEntryAt(rewind, 0)->time;
+    double newest = RewindEntryAt(rewind, rewind->count - 1)->time;
+    double shown = RewindEntryAt(rewind, rewind->viewIndex)->time;
+    float fraction = (newest > oldest) ? (float)((shown - oldest) / (newest - oldest)) : 1.0f;
+
+    DrawRectangleRec(bar, Fade(BLACK, 0.5f));
+    DrawRectangle((int)bar.x, (int)bar.y, (int)(bar.width * fraction), (int)bar.height, Fade(SKYBLUE, 0.8f));
+    DrawRectangle((int)(bar.x + bar.width * fraction) - 2, (int)bar.y - 6, 4, (int)bar.height + 12, WHITE);
+    DrawTextEx(font, TextFormat("Rewind  -%.1fs of %.0fs", newest - shown, newest - oldest), (Vector2){bar.x, bar.y + 20}, 24, 2, WHITE);
+    DrawTextEx(font, "LEFT/RIGHT or drag: scrub   ENTER: play from here   R: back to live",
+               (Vector2){bar.x + bar.width - 760, bar.y + 20}, 20, 2, LIGHTGRAY);
+}
+
+// Index on the timeline under the mouse, or -1 if it is not over it
+int RewindBarIndex(RewindBuffer *rewind, Vector2 mouse)
+{
+    Rectangle bar = {100, 12, (float)(GetScreenWidth() - 200), 36};
+    if (rewind->count == 0 || !CheckCollisionPointRec(mouse, bar)) return -1;
+    double oldest = RewindEntryAt(rewind, 0)->time;
+    double newest = RewindEntryAt(rewind, rewind->count - 1)->time;
+    double target = oldest + (newest - oldest) * Clamp((mouse.x - bar.x) / bar.width, 0.0f, 1.0f);
+    int lo = 0, hi = rewind->count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (RewindEntryAt(rewind, mid)->time < target) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+#else
+// The viewer side: receives deltas, rebuilds snapshots and acks them
+typedef struct
+{
+    PlatformSocket socket;
+    uint8_t *inbox;
+    size_t inboxSize;
+    size_t inboxCapacity;
+    SpectatorHello hello;
+    bool haveHello;
+    size_t snapshotSize;
+    uint8_t *history[SPECTATOR_HISTORY];
+    uint32_t historyTick[SPECTATOR_HISTORY];
+    uint32_t latestTick;
+} SpectatorViewer;
+
+// Reads whatever has arrived and handles every complete message. Returns
+// false once the connection is gone.
+static bool ReceiveSpectatorMessages(SpectatorViewer *viewer, bool *snapshotArrived)
+{
+    for (;;) {
+        if (viewer->inboxSize == viewer->inboxCapacity) {
+            size_t capacity = viewer->inboxCapacity ? viewer->inboxCapacity * 2 : 4096;
+            uint8_t *grown = realloc(viewer->inbox, capacity);
+            if (grown == NULL) return false;
+            viewer->inbox = grown;
+            viewer->inboxCapacity = capacity;
         }
+        long received = PlatformRecv(viewer->socket, viewer->inbox + viewer->inboxSize,
+                                     viewer->inboxCapacity - viewer->inboxSize);
+        if (received < 0) return false;
+        if (received == 0) break;
+        viewer->inboxSize += (size_t)received;
     }
 
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        Projectile *proj = &game->projectiles[i];
-        if (proj->active) {
-            if (proj->type == STONE) {
-                DrawCircleV(proj->pos, 3, GRAY);
-            } else if (proj->type == BULLET) {
-                DrawCircleV(proj->pos, 2, RED);
-            } else if (proj->type == HELICOPTER_BULLET) {
-                DrawCircleV(proj->pos, 3, ORANGE);
+    size_t offset = 0;
+    while (viewer->inboxSize - offset >= sizeof(SpectatorMessage)) {
+        SpectatorMessage message;
+        memcpy(&message, viewer->inbox + offset, sizeof(message));
+        if (message.magic != SPECTATOR_MAGIC) return false;
+        if (viewer->inboxSize - offset - sizeof(message) < message.payloadSize) break;
+        const uint8_t *payload = viewer->inbox + offset + sizeof(message);
+        offset += sizeof(message) + message.payloadSize;
+
+        if (message.type == SPECTATOR_HELLO && message.payloadSize == sizeof(SpectatorHello)) {
+            memcpy(&viewer->hello, payload, sizeof(SpectatorHello));
+            viewer->haveHello = true;
+        } else if (message.type == SPECTATOR_DELTA && viewer->snapshotSize > 0) {
+            const uint8_t *base = NULL;
+            int baseSlot = message.baseTick % SPECTATOR_HISTORY;
+            if (message.baseTick != 0) {
+                if (viewer->historyTick[baseSlot] != message.baseTick) continue; // base already evicted
+                base = viewer->history[baseSlot];
             }
+            int slot = message.tick % SPECTATOR_HISTORY;
+            if (!DecodeSnapshotDelta(base, payload, message.payloadSize, viewer->history[slot], viewer->snapshotSize)) {
+                return false;
+            }
+            viewer->historyTick[slot] = message.tick;
+            viewer->latestTick = message.tick;
+            *snapshotArrived = true;
+
+            SpectatorMessage ack = {SPECTATOR_MAGIC, SPECTATOR_ACK, message.tick, 0, 0};
+            if (PlatformSend(viewer->socket, &ack, sizeof(ack)) != (long)sizeof(ack)) return false;
         }
     }
+    memmove(viewer->inbox, viewer->inbox + offset, viewer->inboxSize - offset);
+    viewer->inboxSize -= offset;
+    return true;
+}
 
-    if (textures[7].id != 0) {
-        DrawTexture(textures[7], 0, 0, WHITE);
+// Connects to a running game and waits for its pool sizes
+bool ConnectSpectatorViewer(SpectatorViewer *viewer, ScenarioConfig *scenario)
+{
+    memset(viewer, 0, sizeof(SpectatorViewer));
+    int port = scenario->spectatorPort ? scenario->spectatorPort : SPECTATOR_DEFAULT_PORT;
+    if (!PlatformSocketsInit()) return false;
+    viewer->socket = PlatformConnectLoopback(port);
+    if (viewer->socket == PLATFORM_INVALID_SOCKET) {
+        TraceLog(LOG_ERROR, "SPECTATOR: No game is streaming on port %d", port);
+        PlatformSocketsShutdown();
+        return false;
     }
 
-    if (textures[8].id != 0) {
-        Rectangle src = {0, 0, (float)textures[8].width, (float)textures[8].height};
-        Rectangle dest = {0, 0, 1600, 900};
-        DrawTexturePro(textures[8], src, dest, (Vector2){0, 0}, 0.0f, WHITE);
+    bool snapshotArrived = false;
+    for (double deadline = GetTime() + 5.0; !viewer->haveHello && GetTime() < deadline; WaitTime(0.01)) {
+        if (!ReceiveSpectatorMessages(viewer, &snapshotArrived)) break;
+    }
+    if (!viewer->haveHello) {
+        TraceLog(LOG_ERROR, "SPECTATOR: Game did not answer");
+        PlatformCloseSocket(viewer->socket);
+        PlatformSocketsShutdown();
+        return false;
     }
+    scenario->maxProtesters = (int)viewer->hello.maxProtesters;
+    scenario->maxPolice = (int)viewer->hello.maxPolice;
+    scenario->maxProjectiles = (int)viewer->hello.maxProjectiles;
+    scenario->maxGas = (int)viewer->hello.maxGas;
+    scenario->worldWidth = (int)viewer->hello.worldWidth;
+    return true;
+}
 
-    DrawUI(game, pixelFont, textures);
+// Allocates snapshot storage once the viewer's GameState exists
+bool BeginSpectatorStream(SpectatorViewer *viewer, const GameState *game)
+{
+    viewer->snapshotSize = SnapshotSize(game);
+    uint8_t *buffers = calloc(SPECTATOR_HISTORY, viewer->snapshotSize);
+    if (buffers == NULL) return false;
+    for (int h = 0; h < SPECTATOR_HISTORY; h++) viewer->history[h] = buffers + h * viewer->snapshotSize;
+    return true;
 }
 
-void DrawUI(GameState *game, Font pixelFont, Texture2D *textures)
+// Applies the newest snapshot to the local GameState. Returns false once
+// the game has gone away.
+bool UpdateSpectatorViewer(SpectatorViewer *viewer, GameState *game)
 {
-    const int screenWidth = 1600;
-    const int screenHeight = 900;
+    bool snapshotArrived = false;
+    if (!ReceiveSpectatorMessages(viewer, &snapshotArrived)) {
+        TraceLog(LOG_INFO, "SPECTATOR: Stream ended");
+        return false;
+    }
+    if (snapshotArrived) {
+        ReadSnapshot(game, viewer->history[viewer->latestTick % SPECTATOR_HISTORY]);
+    }
+    // The stream carries elapsed times, not clocks; the HUD reads them
+    // against this local one
+    game->time += GetFrameTime();
+    if (game->menuState == MENU_PLAY) game->animTime += GetFrameTime();
+    UpdateGameCamera(game, GetFrameTime());
+    return true;
+}
 
-    DrawRectangle(0, 0, screenWidth, 110, Fade(BLACK, 0.6f));
-    DrawRectangle(20, 20, 300, 25, LIGHTGRAY);
-    Color moraleColor = (game->globalMorale > 70) ? GREEN : (game->globalMorale > 30) ? YELLOW : RED;
-    DrawRectangle(20, 20, (int)(3 * game->globalMorale), 25, moraleColor);
-    DrawRectangleLines(20, 20, 300, 25, WHITE);
-    DrawTextEx(pixelFont, TextFormat("Movement Morale: %.1f%%", game->globalMorale),
-               (Vector2){330, 22}, 20, 1, WHITE);
+void CloseSpectatorViewer(SpectatorViewer *viewer)
+{
+    PlatformCloseSocket(viewer->socket);
+    PlatformSocketsShutdown();
+    free(viewer->inbox);
+    free(viewer->history[0]);
+    memset(viewer, 0, sizeof(SpectatorViewer));
+}
+#endif
 
-    double elapsed = GetTime() - game->gameStartTime;
-    int timeLeft = (int)(GAME_DURATION - elapsed);
-    if (timeLeft < 0) timeLeft = 0;
-    int minutes = timeLeft / 60;
-    int seconds = timeLeft % 60;
+#ifndef SPECTATOR_VIEWER
+// One row of --sweep output
+typedef struct
+{
+    unsigned int seed;
+    GameMenu outcome; // MENU_WIN or MENU_LOSE, MENU_LOADING if the match failed to start
+    float duration;   // simulated seconds
+    int protesters;
+    int arrested;
+    int police;
+    float morale;
+    float peakMorale;
+    int droppedEvents;    // events lost to a full queue
+    size_t frameArenaPeak; // bytes
+} SweepResult;
 
-    DrawTextEx(pixelFont, TextFormat("Time: %02d:%02d", minutes, seconds),
-               (Vector2){screenWidth - 200, 20}, 24, 1, WHITE);
+typedef struct
+{
+    ScenarioConfig scenario;
+    SweepResult *results;
+} SweepJob;
 
-    DrawTextEx(pixelFont, TextFormat("Active Protesters: %d", game->protesterCount),
-               (Vector2){20, 60}, 18, 1, WHITE);
-    DrawTextEx(pixelFont, TextFormat("Arrested: %d", game->protesters_arrested),
-               (Vector2){20, 85}, 18, 1, WHITE);
+// One headless match with no input, stepped at SWEEP_TICK_RATE until it is
+// decided. The lose condition's GAME_DURATION bounds it.
+static void RunSweepMatch(void *context, int index)
+{
+    SweepJob *job = (SweepJob *)context;
+    SweepResult *result = &job->results[index];
+    ScenarioConfig scenario = job->scenario;
+    scenario.seed += (unsigned int)index;
+    scenario.telemetryPath = NULL;
+    scenario.spectatorPort = 0;
+    result->seed = scenario.seed;
+    result->outcome = MENU_LOADING;
 
-    int advancedProtesters = 0;
-    for (int i = 0; i < MAX_PROTESTERS; i++)
-    {
-        if (game->protesters[i].alive && game->protesters[i].pos.x > 800)
-        {
-            advancedProtesters++;
-        }
+    GameState *game = malloc(sizeof(GameState));
+    if (game == NULL || !InitGame(game, scenario)) {
+        free(game);
+        return;
     }
-    float controlPercentage = game->protesterCount > 0 ? (float)advancedProtesters / game->protesterCount : 0.0f;
+    SyntheticPlayer bot;
+    if (scenario.botCrowd > 0) {
+        InitSyntheticPlayer(&bot, &scenario);
+        game->inputSource = &bot.source;
+    }
+    game->menuState = MENU_PLAY;
+    while (game->menuState == MENU_PLAY) {
+        BeginGameFrame(game);
+        UpdateGame(game, 1.0f / SWEEP_TICK_RATE);
+    }
+    *result = (SweepResult){
+        .seed = scenario.seed,
+        .outcome = game->menuState,
+        .duration = (float)(game->time - game->gameStartTime),
+        .protesters = game->protesterCount,
+        .arrested = game->protesters_arrested,
+        .police = game->policeCount,
+        .morale = game->globalMorale,
+        .peakMorale = game->max_morale_reached,
+        .droppedEvents = game->stats.dropped,
+        .frameArenaPeak = game->frameArena.highWater
+    };
+    ShutdownGame(game);
+    free(game);
+}
 
-    DrawTextEx(pixelFont, "Territory Control:", (Vector2){screenWidth - 300, 60}, 18, 1, WHITE);
-    DrawRectangle(screenWidth - 300, 85, 200, 15, LIGHTGRAY);
-    DrawRectangle(screenWidth - 300, 85, (int)(200 * controlPercentage), 15, GREEN);
-    DrawRectangleLines(screenWidth - 300, 85, 200, 15, WHITE);
+// --sweep N: plays N matches with consecutive seeds across the thread pool
+// and prints one CSV row per match to stdout
+bool RunSweep(ScenarioConfig scenario)
+{
+    SweepJob job = {scenario, calloc((size_t)scenario.sweepMatches, sizeof(SweepResult))};
+    if (job.results == NULL) {
+        TraceLog(LOG_ERROR, "SWEEP: Out of memory for %d matches", scenario.sweepMatches);
+        return false;
+    }
+    ThreadPool pool;
+    StartThreadPool(&pool, scenario.threads);
+    TraceLog(LOG_INFO, "SWEEP: %d matches from seed %u on %d threads", scenario.sweepMatches, scenario.seed, pool.threadCount + 1);
+    RunParallel(&pool, scenario.sweepMatches, RunSweepMatch, &job);
+    StopThreadPool(&pool);
 
-    // Debug information
-    DrawTextEx(pixelFont, TextFormat("Control: %.1f%%", controlPercentage * 100), (Vector2){screenWidth - 300, 110}, 16, 1, WHITE);
-    DrawTextEx(pixelFont, TextFormat("Control Time: %.1f", game->controlStartTime > 0 ? GetTime() - game->controlStartTime : 0), (Vector2){screenWidth - 300, 130}, 16, 1, WHITE);
-    DrawTextEx(pixelFont, TextFormat("Police Left: %d", game->policeCount), (Vector2){screenWidth - 300, 150}, 16, 1, WHITE);
+    bool ok = true;
+    printf("seed,outcome,duration_s,protesters,arrested,police,morale,peak_morale,dropped_events,frame_arena_peak\n");
+    for (int i = 0; i < scenario.sweepMatches; i++) {
+        const SweepResult *r = &job.results[i];
+        const char *outcome = (r->outcome == MENU_WIN) ? "win" : (r->outcome == MENU_LOSE) ? "lose" : "error";
+        if (r->outcome == MENU_LOADING) ok = false;
+        printf("%u,%s,%.2f,%d,%d,%d,%.1f,%.1f,%d,%zu\n", r->seed, outcome, r->duration, r->protesters,
+               r->arrested, r->police, r->morale, r->peakMorale, r->droppedEvents, r->frameArenaPeak);
+    }
+    free(job.results);
+    return ok;
+}
+#endif
 
-    if (game->isSelecting) {
-        float minX = fminf(game->selectStart.x, game->selectEnd.x);
-        float maxX = fmaxf(game->selectStart.x, game->selectEnd.x);
-        float minY = fminf(game->selectStart.y, game->selectEnd.y);
-        float maxY = fmaxf(game->selectStart.y, game->selectEnd.y);
-        DrawRectangleLines((int)minX, (int)minY, (int)(maxX - minX), (int)(maxY - minY), BLUE);
+// Reads a scenario file into `scenario`. One directive per line, '#' starts
+// a comment:
+//
+//   world-width 4800                  pool sizes and map bounds, as the
+//   protesters 5000                   command-line flags of the same names
+//   start protesters 2000 50 300      starting forces in an x band
+//   start police 40 -400 -100         (negative x counts from the right edge)
+//   wave 60 police 30 -200 -50        arrivals 60 seconds into the match
+//
+// Factions without a `start` line begin with their whole pool, as without
+// a file. Malformed lines are reported and skipped.
+bool LoadScenarioFile(ScenarioConfig *scenario, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        TraceLog(LOG_WARNING, "SCENARIO: Could not open %s", path);
+        return false;
     }
+    char line[256];
+    for (int number = 1; fgets(line, sizeof(line), file) != NULL; number++) {
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        char key[32];
+        char faction[32];
+        int value = 0;
+        if (sscanf(line, " %31s", key) != 1) continue;
 
-    if (game->policeSurgeActive) {
-        double timeLeft = game->policeSurgeEnd - GetTime();
-        if (timeLeft > 0) {
-            DrawTextEx(pixelFont, TextFormat("Police Surge: %.1f sec", timeLeft),
-                       (Vector2){screenWidth / 2 - 100, 20}, 24, 1, RED);
+        bool ok = false;
+        if (strcmp(key, "start") == 0 || strcmp(key, "wave") == 0) {
+            SpawnWave wave = {0};
+            if (strcmp(key, "start") == 0) {
+                ok = sscanf(line, " %*s %31s %d %f %f", faction, &wave.count, &wave.minX, &wave.maxX) == 4;
+            } else {
+                ok = sscanf(line, " %*s %f %31s %d %f %f", &wave.time, faction, &wave.count, &wave.minX, &wave.maxX) == 5 &&
+                     wave.time > 0.0f;
+            }
+            if (ok && strcmp(faction, "protesters") == 0) wave.faction = FACTION_PROTESTER;
+            else if (ok && strcmp(faction, "police") == 0) wave.faction = FACTION_POLICE;
+            else ok = false;
+            ok = ok && wave.count > 0 && scenario->waveCount < MAX_SCENARIO_WAVES;
+            if (ok) scenario->waves[scenario->waveCount++] = wave;
+        } else if (sscanf(line, " %*s %d", &value) == 1 && value > 0) {
+            ok = true;
+            if (strcmp(key, "protesters") == 0) scenario->maxProtesters = value;
+            else if (strcmp(key, "police") == 0) scenario->maxPolice = value;
+            else if (strcmp(key, "projectiles") == 0) scenario->maxProjectiles = value;
+            else if (strcmp(key, "gas") == 0) scenario->maxGas = value;
+            else if (strcmp(key, "world-width") == 0) scenario->worldWidth = (value > DEFAULT_WORLD_WIDTH) ? value : DEFAULT_WORLD_WIDTH;
+            else ok = false;
         }
+        if (!ok) TraceLog(LOG_WARNING, "SCENARIO: %s:%d: cannot use \"%s\", skipped", path, number, key);
     }
+    fclose(file);
+    return true;
 }
 
-void UnloadGameTextures(GameState *game) {
-    for (int i = 0; i < MAX_PROTESTERS; i++) {
-        for (int j = 0; j < 2; j++) {
-            if (game->protesters[i].sprites[j].id != 0) UnloadTexture(game->protesters[i].sprites[j]);
-        }
-        for (int j = 0; j < 3; j++) {
-            if (game->protesters[i].run_sprites[j].id != 0) UnloadTexture(game->protesters[i].run_sprites[j]);
+// Gives factions without starting forces their whole pool in the default
+// bands, then orders the waves by arrival time
+static void FinishScenarioWaves(ScenarioConfig *scenario)
+{
+    static const SpawnWave defaults[2] = {
+        [FACTION_PROTESTER] = {0.0f, FACTION_PROTESTER, 0, 50.0f, 300.0f},
+        [FACTION_POLICE] = {0.0f, FACTION_POLICE, 0, -400.0f, -100.0f},
+    };
+    for (int faction = FACTION_POLICE; faction >= FACTION_PROTESTER; faction--) {
+        bool starts = false;
+        for (int w = 0; w < scenario->waveCount; w++) {
+            starts = starts || (scenario->waves[w].faction == faction && scenario->waves[w].time <= 0.0f);
         }
+        if (starts) continue;
+        if (scenario->waveCount == MAX_SCENARIO_WAVES) scenario->waveCount--; // the last wave gives way
+        memmove(&scenario->waves[1], &scenario->waves[0], sizeof(SpawnWave) * scenario->waveCount);
+        scenario->waves[0] = defaults[faction];
+        scenario->waves[0].count = (faction == FACTION_POLICE) ? scenario->maxPolice : scenario->maxProtesters;
+        scenario->waveCount++;
     }
-    for (int i = 0; i < MAX_POLICE; i++) {
-        for (int j = 0; j < 2; j++) {
-            if (game->police[i].sprites[j].id != 0) UnloadTexture(game->police[i].sprites[j]);
+    for (int w = 1; w < scenario->waveCount; w++) {
+        SpawnWave wave = scenario->waves[w];
+        int j = w;
+        for (; j > 0 && scenario->waves[j - 1].time > wave.time; j--) scenario->waves[j] = scenario->waves[j - 1];
+        scenario->waves[j] = wave;
+    }
+}
+
+// Reads pool capacities from the command line, e.g. "--protesters 5000"
+ScenarioConfig ParseScenarioArgs(int argc, char **argv)
+{
+    ScenarioConfig scenario = DefaultScenario();
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--low-latency") == 0) scenario.lowLatency = true;
+    }
+    // The file is read first so any flag can override it
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--scenario") == 0) LoadScenarioFile(&scenario, argv[i + 1]);
+    }
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--scenario") == 0) {
+            i++;
+            continue;
         }
-        for (int j = 0; j < 3; j++) {
-            if (game->police[i].run_sprites[j].id != 0) UnloadTexture(game->police[i].run_sprites[j]);
+        if (strcmp(argv[i], "--telemetry") == 0) {
+            scenario.telemetryPath = argv[++i];
+            continue;
         }
+        if (strcmp(argv[i], "--record") == 0) {
+            scenario.recordPath = argv[++i];
+            continue;
+        }
+        int value = atoi(argv[i + 1]);
+        // Bot rates may be 0 to switch that action off
+        int *rate = NULL;
+        if (strcmp(argv[i], "--bot-select") == 0) rate = &scenario.botSelectRate;
+        else if (strcmp(argv[i], "--bot-orders") == 0) rate = &scenario.botOrderRate;
+        else if (strcmp(argv[i], "--bot-volleys") == 0) rate = &scenario.botVolleyRate;
+        else if (strcmp(argv[i], "--bot-retreats") == 0) rate = &scenario.botRetreatRate;
+        if (rate != NULL) {
+            *rate = (value > 0) ? value : 0;
+            i++;
+            continue;
+        }
+        if (value <= 0) continue;
+        if (strcmp(argv[i], "--protesters") == 0) scenario.maxProtesters = value;
+        else if (strcmp(argv[i], "--police") == 0) scenario.maxPolice = value;
+        else if (strcmp(argv[i], "--projectiles") == 0) scenario.maxProjectiles = value;
+        else if (strcmp(argv[i], "--gas") == 0) scenario.maxGas = value;
+        else if (strcmp(argv[i], "--world-width") == 0) scenario.worldWidth = (value > DEFAULT_WORLD_WIDTH) ? value : DEFAULT_WORLD_WIDTH;
+        else if (strcmp(argv[i], "--telemetry-rate") == 0) scenario.telemetryRate = value;
+        else if (strcmp(argv[i], "--spectator-port") == 0) scenario.spectatorPort = value;
+        else if (strcmp(argv[i], "--seed") == 0) scenario.seed = (unsigned int)value;
+        else if (strcmp(argv[i], "--sweep") == 0) scenario.sweepMatches = value;
+        else if (strcmp(argv[i], "--bot") == 0) scenario.botCrowd = value;
+        else if (strcmp(argv[i], "--crowd-iterations") == 0) scenario.crowdIterations = value;
+        else if (strcmp(argv[i], "--threads") == 0) scenario.threads = (value < MAX_WORKER_THREADS) ? value : MAX_WORKER_THREADS;
+        else continue;
+        i++;
     }
+    if (scenario.seed == 0) scenario.seed = (unsigned int)time(NULL);
+    FinishScenarioWaves(&scenario);
+    return scenario;
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
+    ScenarioConfig scenario = ParseScenarioArgs(argc, argv);
+#ifndef SPECTATOR_VIEWER
+    if (scenario.sweepMatches > 0) return RunSweep(scenario) ? 0 : 1;
+#endif
+
     const int screenWidth = 1600;
     const int screenHeight = 900;
     InitWindow(screenWidth, screenHeight, "A Day In July");
     InitAudioDevice(); // Initialize audio device
-    SetTargetFPS(60);
+    SetTargetFPS(0); // frames are paced at the end of the loop so their work can be measured
+
+#ifdef SPECTATOR_VIEWER
+    // The viewer mirrors a running game, so its pools follow the game's
+    static SpectatorViewer viewer;
+    if (!ConnectSpectatorViewer(&viewer, &scenario)) {
+        CloseAudioDevice();
+        CloseWindow();
+        return 1;
+    }
+#endif
 
     GameState game;
-    InitGame(&game);
+    if (!InitGame(&game, scenario)) {
+        CloseAudioDevice();
+        CloseWindow();
+        return 1;
+    }
 
-    Music bgm = LoadMusicStream("game_bgm.mp3"); // Load background music
-    SetMusicVolume(bgm, 0.5f); // Set volume to 50%
+    game.menuState = MENU_LOADING;
+    // With --bot the synthetic player drives, and matches start and restart
+    // on their own so a soak can run unattended
+    static SyntheticPlayer bot;
+    bool autoplay = scenario.botCrowd > 0;
+    if (autoplay) {
+        InitSyntheticPlayer(&bot, &scenario);
+        game.inputSource = &bot.source;
+    } else {
+        game.inputSource = &playerInput.source;
+    }
 
-    Font pixelFont = LoadFont("pixel_font.ttf");
-    if (pixelFont.texture.id == 0) {
-        pixelFont = GetFontDefault();
+    static TelemetryWriter telemetry;
+    StartTelemetry(&telemetry, &game);
+    static FrameRecorder recorder;
+    StartFrameRecorder(&recorder, scenario.recordPath);
+    static LatencyMonitor latency;
+#ifdef SPECTATOR_VIEWER
+    StartLatencyMonitor(&latency, false); // the viewer's clock runs on GetFrameTime
+#else
+    StartLatencyMonitor(&latency, scenario.lowLatency);
+#endif
+#ifdef SPECTATOR_VIEWER
+    if (!BeginSpectatorStream(&viewer, &game)) {
+        CloseSpectatorViewer(&viewer);
+        ShutdownGame(&game);
+        CloseAudioDevice();
+        CloseWindow();
+        return 1;
     }
+#else
+    static SpectatorServer spectators;
+    StartSpectatorServer(&spectators, &game);
+    static ThreadPool workers;
+    StartThreadPool(&workers, scenario.threads);
+    game.workers = &workers;
+    static ParticleSystem particles;
+    if (InitParticleSystem(&particles, PARTICLE_CAPACITY)) game.particles = &particles;
+    static RewindBuffer rewind;
+    InitRewindBuffer(&rewind, &game);
+#endif
 
+    // Everything is decoded off the render thread; the loading screen
+    // below uploads it a few milliseconds per frame.
+    static AssetLoader loader = {0};
+    AssetArchive archive = {0};
+    if (OpenAssetArchive(&archive, PACK_FILE_NAME)) loader.archive = &archive;
+    GameAssets assets = {0};
+    static AudioSystem audio;
+    Font pixelFont = GetFontDefault();
     Texture2D textures[10] = {0};
     const char *textureFiles[] = {
         "protester.png", "police.png", "bus.png", "car.png", "tear_gas.png",
-        "agitator.png", "bg2.png", "dhaka_skyline.png", "bottom_building.png", "helicopter.png"
-    };
+        "agitator.png", NULL, "dhaka_skyline.png", "bottom_building.png", "helicopter.png"
+    }; // slot 6 (bg2.png) is streamed as background tiles instead
 
+    LayerCache layers;
+    LoadLayerCache(&layers, screenWidth, screenHeight);
+
+    QueueAsset(&loader, "pixel_font.ttf", ASSET_FONT, &pixelFont);
+    QueueGameAssets(&loader, &assets);
     for (int i = 0; i < 10; i++) {
-        textures[i] = LoadTexture(textureFiles[i]);
-        if (textures[i].id != 0) {
-            SetTextureFilter(textures[i], TEXTURE_FILTER_POINT);
-        }
+        if (textureFiles[i] != NULL) QueueAsset(&loader, textureFiles[i], ASSET_TEXTURE, &textures[i]);
     }
+    QueueAsset(&loader, "bg2.png", ASSET_IMAGE, &layers.background.sources[0]);
+    QueueAsset(&loader, "background.png", ASSET_IMAGE, &layers.background.sources[1]);
+    QueueAsset(&loader, MUSIC_FILE_NAME, ASSET_MUSIC, &audio.music);
+    StartAssetLoader(&loader);
 
     while (!WindowShouldClose()) {
-        UpdateMusicStream(bgm); // Update music stream
+        if (latency.lowLatency) PollInputLate(&latency);
+        playerInput.polledAt = latency.polledAt;
+        double frameStart = GetTime();
+        if (IsKeyPressed(KEY_F3)) latency.overlay = !latency.overlay;
+        BeginGameFrame(&game);
+#ifdef SPECTATOR_VIEWER
+        // Nothing is simulated here: menus and world both come from the stream
+        if (game.menuState == MENU_LOADING) {
+            if (PumpAssetLoader(&loader, ASSET_UPLOAD_BUDGET)) {
+                BuildStaticLayers(&layers, textures);
+                BuildSpriteAtlas(&assets);
+                game.menuState = MENU_START;
+            }
+        } else if (!UpdateSpectatorViewer(&viewer, &game)) {
+            break;
+        } else {
+            SampleTelemetry(&telemetry, &game);
+        }
+#else
         switch (game.menuState) {
+            case MENU_LOADING:
+                if (PumpAssetLoader(&loader, ASSET_UPLOAD_BUDGET)) {
+                    BuildStaticLayers(&layers, textures);
+                    BuildSpriteAtlas(&assets);
+                    if (StartAudioSystem(&audio)) game.audio = &audio;
+                    game.menuState = MENU_START;
+                }
+                break;
             case MENU_START:
-                StopMusicStream(bgm); // Ensure music is stopped in menu
-                if (IsKeyPressed(KEY_ENTER)) {
+                SetMusicState(&audio, MUSIC_STOPPED); // Ensure music is stopped in menu
+                if (IsKeyPressed(KEY_ENTER) || autoplay) {
                     game.menuState = MENU_PLAY;
-                    PlayMusicStream(bgm); // Start music when entering play state
+                    ClearRewindBuffer(&rewind);
+                    SetMusicState(&audio, MUSIC_PLAYING); // Start music when entering play state
                 }
                 if (IsKeyPressed(KEY_T)) game.menuState = MENU_TUTORIAL;
                 break;
             case MENU_TUTORIAL:
-                StopMusicStream(bgm); // Stop music in tutorial
+                SetMusicState(&audio, MUSIC_STOPPED); // Stop music in tutorial
                 if (IsKeyPressed(KEY_ENTER)) game.menuState = MENU_START;
                 break;
             case MENU_PAUSE:
-                PauseMusicStream(bgm); // Pause music during pause
+                SetMusicState(&audio, MUSIC_PAUSED); // Pause music during pause
                 if (IsKeyPressed(KEY_ENTER)) {
                     game.menuState = MENU_PLAY;
-                    ResumeMusicStream(bgm); // Resume music when unpausing
+                    SetMusicState(&audio, MUSIC_PLAYING); // Resume music when unpausing
                 }
                 break;
+            case MENU_REWIND: {
+                int index = rewind.viewIndex;
+                int under = IsMouseButtonDown(MOUSE_LEFT_BUTTON) ? RewindBarIndex(&rewind, GetMousePosition()) : -1;
+                if (under >= 0) index = under;
+                if (IsKeyDown(KEY_LEFT)) index--;
+                if (IsKeyDown(KEY_RIGHT)) index++;
+                if (IsKeyPressed(KEY_R)) index = rewind.count - 1;
+                SeekRewind(&rewind, &game, index);
+                if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_R)) {
+                    ResumeFromRewind(&rewind);
+                    game.menuState = MENU_PLAY;
+                    SetMusicState(&audio, MUSIC_PLAYING);
+                }
+                break;
+            }
             case MENU_WIN:
             case MENU_LOSE:
-                StopMusicStream(bgm); // Stop music on win or lose
-                if (IsKeyPressed(KEY_ENTER)) {
-                    UnloadGameTextures(&game);
-                    InitGame(&game);
-                    game.menuState = MENU_START;
+                SetMusicState(&audio, MUSIC_STOPPED); // Stop music on win or lose
+                if (IsKeyPressed(KEY_ENTER) || autoplay) {
+                    ResetGame(&game);
+                    ClearRewindBuffer(&rewind);
                 }
                 break;
-            default:
+            default: {
                 if (IsKeyPressed(KEY_P)) {
                     game.menuState = MENU_PAUSE;
-                    PauseMusicStream(bgm); // Pause music when pausing
+                    SetMusicState(&audio, MUSIC_PAUSED); // Pause music when pausing
+                }
+                if (IsKeyPressed(KEY_R) && !autoplay) {
+                    // Freeze on the present; scrubbing then moves back from it
+                    CaptureRewind(&rewind, &game, true);
+                    game.menuState = MENU_REWIND;
+                    SetMusicState(&audio, MUSIC_PAUSED);
+                    SeekRewind(&rewind, &game, rewind.count - 1);
+                    break;
                 }
-                UpdateGame(&game);
+                float frameTime = latency.lowLatency ? (float)latency.frameTime : GetFrameTime();
+                UpdateGameCamera(&game, frameTime);
+                SetAudioListener(&audio, game.camera);
+                StepGameFrame(&game, &latency, frameTime);
+                if (game.particles != NULL) UpdateParticles(game.particles, frameTime);
+                FlushGameSounds(&audio);
+                SampleTelemetry(&telemetry, &game);
+                CaptureRewind(&rewind, &game, false);
                 break;
+            }
         }
+        if (game.menuState != MENU_LOADING) PublishSpectatorState(&spectators, &game);
+#endif
 
         BeginDrawing();
         ClearBackground(RAYWHITE);
 
-        if (game.menuState == MENU_START) {
+        if (game.menuState == MENU_LOADING) {
+            float progress = AssetLoaderProgress(&loader);
+            DrawTextEx(pixelFont, "Loading...", (Vector2){screenWidth / 2 - 100, 380}, 32, 2, DARKGRAY);
+            DrawRectangle(screenWidth / 2 - 200, 430, 400, 20, LIGHTGRAY);
+            DrawRectangle(screenWidth / 2 - 200, 430, (int)(400 * progress), 20, DARKBLUE);
+            DrawRectangleLines(screenWidth / 2 - 200, 430, 400, 20, DARKGRAY);
+        } else if (game.menuState == MENU_START) {
             DrawTextEx(pixelFont, "July Uprising Simulator", (Vector2){screenWidth / 2 - 300, 200}, 64, 2, DARKBLUE);
             DrawTextEx(pixelFont, "Quota Movement", (Vector2){screenWidth / 2 - 150, 280}, 36, 2, DARKGRAY);
             DrawTextEx(pixelFont, "Press ENTER to Start", (Vector2){screenWidth / 2 - 180, 400}, 32, 2, DARKGRAY);
@@ -1275,12 +6466,13 @@ int main(void)
             DrawTextEx(pixelFont, "T: Throw stones at nearest police (selected protesters)", (Vector2){50, 280}, 24, 2, DARKGRAY);
             DrawTextEx(pixelFont, "States: Idle -> Chant -> Riot -> Idle (cycle with right click)", (Vector2){50, 320}, 24, 2, DARKGRAY);
             DrawTextEx(pixelFont, "A: Select all protesters", (Vector2){50, 360}, 24, 2, DARKGRAY);
-            DrawTextEx(pixelFont, "SPACE: Emergency retreat", (Vector2){50, 400}, 24, 2, DARKGRAY);
-            DrawTextEx(pixelFont, "P: Pause game (pauses background music)", (Vector2){50, 440}, 24, 2, DARKGRAY);
+            DrawTextEx(pixelFont, "SPACE: Emergency retreat, B: Park the bus or car under the cursor as a barricade", (Vector2){50, 400}, 24, 2, DARKGRAY);
+            DrawTextEx(pixelFont, "P: Pause game (pauses background music), R: Rewind the last minute", (Vector2){50, 440}, 24, 2, DARKGRAY);
             DrawTextEx(pixelFont, "Helicopter: Appears from right, attacks, then leaves left side", (Vector2){50, 480}, 24, 2, ORANGE);
             DrawTextEx(pixelFont, "Background Music: Plays during game, stops on win/lose", (Vector2){50, 520}, 24, 2, DARKGRAY);
             DrawTextEx(pixelFont, "Goal: Control territory (>50%) with high morale (>60) or defeat all police", (Vector2){50, 560}, 24, 2, GREEN);
-            DrawTextEx(pixelFont, "Press ENTER to return", (Vector2){screenWidth / 2 - 180, 600}, 32, 2, DARKGRAY);
+            DrawTextEx(pixelFont, "Arrow keys / Middle Drag: Pan the street, Mouse Wheel: Zoom, F3: Input latency", (Vector2){50, 600}, 24, 2, DARKGRAY);
+            DrawTextEx(pixelFont, "Press ENTER to return", (Vector2){screenWidth / 2 - 180, 640}, 32, 2, DARKGRAY);
         } else if (game.menuState == MENU_PAUSE) {
             DrawTextEx(pixelFont, "Paused", (Vector2){screenWidth / 2 - 100, 200}, 64, 2, DARKBLUE);
             DrawTextEx(pixelFont, "Press ENTER to Resume", (Vector2){screenWidth / 2 - 200, 400}, 32, 2, DARKGRAY);
@@ -1296,18 +6488,45 @@ int main(void)
             DrawTextEx(pixelFont, TextFormat("Final morale: %.1f", game.globalMorale), (Vector2){screenWidth / 2 - 200, 330}, 24, 2, DARKGRAY);
             DrawTextEx(pixelFont, "Press ENTER to Restart", (Vector2){screenWidth / 2 - 200, 400}, 32, 2, DARKGRAY);
         } else {
-            DrawGame(&game, pixelFont, textures);
+            double drawStart = GetTime();
+            DrawGame(&game, &assets, &layers, pixelFont, textures);
+            if (game.menuState == MENU_PLAY) RecordSystemTime(&game, TIMING_DRAW, drawStart);
+#ifndef SPECTATOR_VIEWER
+            if (game.menuState == MENU_REWIND) DrawRewindBar(&rewind, pixelFont);
+#endif
         }
 
-        EndDrawing();
+        CaptureFrame(&recorder);
+        DrawLatencyOverlay(&latency, pixelFont); // after the capture, so recordings leave it out
+        double presentedAt = PresentFrame(&latency);
+
+        // Swapping blocks while the GPU is behind, so this covers GPU time too
+        double workTime = presentedAt - frameStart;
+        AdaptWorldScale(&layers, workTime);
+        if (!latency.lowLatency && workTime < FRAME_BUDGET) WaitTime(FRAME_BUDGET - workTime);
     }
 
-    UnloadGameTextures(&game);
+#ifdef SPECTATOR_VIEWER
+    CloseSpectatorViewer(&viewer);
+#else
+    StopSpectatorServer(&spectators);
+    StopThreadPool(&workers);
+    UnloadParticleSystem(&particles);
+    UnloadRewindBuffer(&rewind);
+#endif
+    StopTelemetry(&telemetry);
+    StopFrameRecorder(&recorder);
+    StopLatencyMonitor(&latency);
+    UnloadGameAssets(&assets);
+    UnloadLayerCache(&layers);
+    ShutdownGame(&game);
     for (int i = 0; i < 10; i++) {
         if (textures[i].id != 0) UnloadTexture(textures[i]);
     }
     if (pixelFont.texture.id != 0) UnloadFont(pixelFont);
-    if (bgm.stream.buffer != NULL) UnloadMusicStream(bgm); // Unload music
+    StopAudioSystem(&audio); // before the loader frees the music's file data
+    UnloadAssetLoader(&loader);
+    CloseAssetArchive(&archive);
     CloseAudioDevice(); // Close audio device
     CloseWindow();
     return 0;
@@ -0,0 +1,218 @@
+#if !defined(_WIN32)
+#define _GNU_SOURCE // RTLD_DEFAULT
+#endif
+#include "platform.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+#define SOCKET_WOULD_BLOCK() (WSAGetLastError() == WSAEWOULDBLOCK)
+#define closesocket_ closesocket
+#else
+#define SOCKET_WOULD_BLOCK() (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+#define closesocket_ close
+#endif
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+bool PlatformMapFile(const char *path, MappedFile *file)
+{
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+
+#if defined(_WIN32)
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(fileHandle);
+    if (mapping == NULL) return false;
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    file->data = (const unsigned char *)view;
+    file->size = (size_t)size.QuadPart;
+    file->handle = mapping;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+
+    file->data = (const unsigned char *)view;
+    file->size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void PlatformUnmapFile(MappedFile *file)
+{
+    if (file->data == NULL) return;
+#if defined(_WIN32)
+    UnmapViewOfFile((void *)file->data);
+    CloseHandle((HANDLE)file->handle);
+#else
+    munmap((void *)file->data, file->size);
+#endif
+    file->data = NULL;
+    file->size = 0;
+    file->handle = NULL;
+}
+
+bool PlatformSocketsInit(void)
+{
+#if defined(_WIN32)
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+void PlatformSocketsShutdown(void)
+{
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+static bool SetNonBlocking(PlatformSocket socket)
+{
+#if defined(_WIN32)
+    u_long enabled = 1;
+    return ioctlsocket((SOCKET)socket, FIONBIO, &enabled) == 0;
+#else
+    int flags = fcntl((int)socket, F_GETFL, 0);
+    return flags >= 0 && fcntl((int)socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// Snapshots are small and latency matters more than packet count
+static void SetNoDelay(PlatformSocket socket)
+{
+    int enabled = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&enabled, sizeof(enabled));
+}
+
+static struct sockaddr_in LoopbackAddress(int port)
+{
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+PlatformSocket PlatformListenLoopback(int port)
+{
+    PlatformSocket listener = (PlatformSocket)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == PLATFORM_INVALID_SOCKET) return PLATFORM_INVALID_SOCKET;
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+    struct sockaddr_in address = LoopbackAddress(port);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listener, 4) != 0 || !SetNonBlocking(listener)) {
+        closesocket_(listener);
+        return PLATFORM_INVALID_SOCKET;
+    }
+    return listener;
+}
+
+PlatformSocket PlatformAccept(PlatformSocket listener)
+{
+    PlatformSocket client = (PlatformSocket)accept(listener, NULL, NULL);
+    if (client == PLATFORM_INVALID_SOCKET) return PLATFORM_INVALID_SOCKET;
+    if (!SetNonBlocking(client)) {
+        closesocket_(client);
+        return PLATFORM_INVALID_SOCKET;
+    }
+    SetNoDelay(client);
+    return client;
+}
+
+PlatformSocket PlatformConnectLoopback(int port)
+{
+    PlatformSocket server = (PlatformSocket)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (server == PLATFORM_INVALID_SOCKET) return PLATFORM_INVALID_SOCKET;
+
+    struct sockaddr_in address = LoopbackAddress(port);
+    if (connect(server, (struct sockaddr *)&address, sizeof(address)) != 0 || !SetNonBlocking(server)) {
+        closesocket_(server);
+        return PLATFORM_INVALID_SOCKET;
+    }
+    SetNoDelay(server);
+    return server;
+}
+
+long PlatformSend(PlatformSocket socket, const void *data, size_t size)
+{
+    long sent = (long)send(socket, (const char *)data, (int)size, MSG_NOSIGNAL);
+    if (sent < 0) return SOCKET_WOULD_BLOCK() ? 0 : -1;
+    return sent;
+}
+
+long PlatformRecv(PlatformSocket socket, void *data, size_t size)
+{
+    long received = (long)recv(socket, (char *)data, (int)size, 0);
+    if (received == 0) return -1; // orderly shutdown
+    if (received < 0) return SOCKET_WOULD_BLOCK() ? 0 : -1;
+    return received;
+}
+
+void PlatformCloseSocket(PlatformSocket socket)
+{
+    if (socket != PLATFORM_INVALID_SOCKET) closesocket_(socket);
+}
+
+void *PlatformGLProc(const char *name)
+{
+#if defined(_WIN32)
+    // wglGetProcAddress only knows extensions and post-1.1 functions, and
+    // some drivers signal failure with small integers instead of NULL
+    PROC proc = wglGetProcAddress(name);
+    intptr_t value = (intptr_t)proc;
+    if (value == 0 || value == 1 || value == 2 || value == 3 || value == -1) {
+        HMODULE opengl = GetModuleHandleA("opengl32.dll");
+        proc = (opengl != NULL) ? GetProcAddress(opengl, name) : NULL;
+    }
+    return (void *)proc;
+#else
+    return dlsym(RTLD_DEFAULT, name);
+#endif
+}
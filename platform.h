@@ -0,0 +1,44 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// OS services that need system headers which clash with raylib.h
+// (windows.h in particular). platform.c never includes raylib.h.
+
+typedef struct
+{
+    const unsigned char *data;
+    size_t size;
+    void *handle; // platform-specific mapping handle
+} MappedFile;
+
+// Maps a whole file read-only. Returns false if it cannot be opened.
+bool PlatformMapFile(const char *path, MappedFile *file);
+void PlatformUnmapFile(MappedFile *file);
+
+// Loopback TCP, used by the spectator stream. Sockets are non-blocking
+// once connected or accepted.
+typedef intptr_t PlatformSocket;
+#define PLATFORM_INVALID_SOCKET ((PlatformSocket)-1)
+
+bool PlatformSocketsInit(void);
+void PlatformSocketsShutdown(void);
+// Listens on 127.0.0.1 only, so sessions are never exposed off the machine
+PlatformSocket PlatformListenLoopback(int port);
+// Returns PLATFORM_INVALID_SOCKET when no connection is pending
+PlatformSocket PlatformAccept(PlatformSocket listener);
+PlatformSocket PlatformConnectLoopback(int port);
+// Return the bytes transferred, 0 if the call would block, or -1 once the
+// connection is closed or broken
+long PlatformSend(PlatformSocket socket, const void *data, size_t size);
+long PlatformRecv(PlatformSocket socket, void *data, size_t size);
+void PlatformCloseSocket(PlatformSocket socket);
+
+// Address of an OpenGL function in the current context, NULL if the driver
+// lacks it. For entry points rlgl does not wrap.
+void *PlatformGLProc(const char *name);
+
+#endif // PLATFORM_H
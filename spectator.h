@@ -0,0 +1,112 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include <stdint.h>
+
+// Wire format between the game (server) and the spectator viewer, a build
+// of main.c with -DSPECTATOR_VIEWER. Both ends run on the same machine over
+// loopback, so values are sent in native byte order.
+//
+// Every message is a SpectatorMessage followed by payloadSize bytes:
+//
+//   server -> viewer  SPECTATOR_HELLO  SpectatorHello, once on connect
+//   server -> viewer  SPECTATOR_DELTA  snapshot `tick` encoded against the
+//                                      snapshot `baseTick` (0 = keyframe)
+//   viewer -> server  SPECTATOR_ACK    the viewer now holds snapshot `tick`
+//
+// A snapshot is a flat buffer: SpectatorMatch, then one PackedProtester per
+// protester slot, then WirePolice, WireProjectile and WireGas per slot, then
+// WireHelicopter and one WireVehicle per vehicle slot. Deltas XOR it against the base and run-length encode the
+// result (see EncodeSnapshotDelta), so their size follows what changed, not
+// how many entities exist.
+
+#define SPECTATOR_MAGIC 0x50534441u // "ADSP"
+#define SPECTATOR_DEFAULT_PORT 7777
+#define SPECTATOR_MAX_CLIENTS 4
+#define SPECTATOR_HISTORY 8             // snapshots kept as delta bases
+#define SPECTATOR_KEYFRAME_INTERVAL 300 // ticks between forced keyframes
+
+typedef enum
+{
+    SPECTATOR_HELLO = 1,
+    SPECTATOR_DELTA = 2,
+    SPECTATOR_ACK = 3
+} SpectatorMessageType;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t type;
+    uint32_t tick;
+    uint32_t baseTick;
+    uint32_t payloadSize;
+} SpectatorMessage;
+
+// Pool sizes, so the viewer can allocate the same slots as the game
+typedef struct
+{
+    uint32_t maxProtesters;
+    uint32_t maxPolice;
+    uint32_t maxProjectiles;
+    uint32_t maxGas;
+    uint32_t worldWidth;
+} SpectatorHello;
+
+typedef struct
+{
+    float morale;
+    float control;
+    float elapsed;     // seconds since the match started
+    float controlTime; // seconds of sustained control, 0 if none
+    float surgeLeft;   // seconds of police surge left, negative if none
+    uint32_t menuState;
+    uint32_t protesterCount;
+    uint32_t policeCount;
+    uint32_t arrested;
+} SpectatorMatch;
+
+// Positions use the same 16-bit fixed point as PackedProtester; police
+// stay in the walkable field, projectiles span the whole world height.
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint8_t health; // 0..100
+    uint8_t flags;  // bits 0-2 state, then alive, facing right
+    uint8_t anim_phase;
+    uint8_t reserved;
+} WirePolice;
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint8_t flags; // bit 0 active, bits 1-2 type
+    uint8_t reserved;
+} WireProjectile;
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t radius; // 1/16 pixel
+    uint8_t active;
+    uint8_t reserved;
+} WireGas;
+
+typedef struct
+{
+    float x;
+    float y;
+    uint32_t active;
+} WireHelicopter;
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+    uint8_t flags; // bit 0 active, parked, facing left, bits 3-4 kind
+    uint8_t reserved;
+} WireVehicle;
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+// Layout of a telemetry stream, appended by the game while a match runs and
+// read back by tools/telemetry_report.c:
+//
+//   TelemetryHeader | TelemetryRecord...
+//
+// Records are fixed size and only ever appended, so a file cut short by a
+// crash loses at most its last partial record. Restarting a match keeps
+// the same file; a record whose time goes backwards starts a new match.
+
+#define TELEMETRY_MAGIC 0x4D4C5441u // "ATLM"
+#define TELEMETRY_VERSION 3
+#define TELEMETRY_DEFAULT_RATE 10 // records per second
+#define TELEMETRY_STATE_COUNT 5   // IDLE, CHANT, RIOT, FLEE, ARRESTED
+#define TELEMETRY_HEAT_COLUMNS 32 // protester density grid over the field
+#define TELEMETRY_HEAT_ROWS 8
+
+// Systems whose update cost is recorded, in milliseconds per tick
+typedef enum
+{
+    TIMING_INPUT,
+    TIMING_PROTESTERS,
+    TIMING_VEHICLES,
+    TIMING_CROWD,
+    TIMING_POLICE,
+    TIMING_GAS,
+    TIMING_HELICOPTER,
+    TIMING_PROJECTILES,
+    TIMING_EVENTS,
+    TIMING_DRAW,
+    TIMING_COUNT
+} TelemetryTiming;
+
+static const char *const TELEMETRY_TIMING_NAMES[TIMING_COUNT] = {
+    "input", "protesters", "vehicles", "crowd", "police", "gas", "helicopter", "projectiles", "events", "draw"
+};
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tickRate; // records per second
+    uint32_t worldWidth;
+    uint32_t maxProtesters;
+    uint32_t maxPolice;
+    uint32_t maxProjectiles;
+    uint32_t maxGas;
+    int64_t startTime; // unix time the recording began
+} TelemetryHeader;
+
+typedef struct
+{
+    float time;         // seconds since the match started
+    float morale;       // globalMorale
+    float control;      // fraction of protesters past the midline
+    float policeHealth; // summed over officers still standing
+    uint32_t stateCounts[TELEMETRY_STATE_COUNT]; // live protesters per state; ARRESTED counts arrests
+    uint32_t police;
+    uint32_t projectiles;
+    uint32_t gas;
+    float timings[TIMING_COUNT]; // mean over the ticks since the previous record
+    uint8_t heat[TELEMETRY_HEAT_ROWS * TELEMETRY_HEAT_COLUMNS]; // live protesters per cell, saturating
+} TelemetryRecord;
+
+#endif
@@ -0,0 +1,131 @@
+// Bundles every runtime asset listed in PACK_MANIFEST into a single archive.
+// Images are decoded here, once, so the game can upload them without
+// inflating PNGs at startup.
+//
+// Usage: asset_packer [output.pak] [asset_dir]
+
+#include "raylib.h"
+#include "../asset_pack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    const PackManifestEntry *source;
+    Image image;
+    unsigned char *data;
+    int dataSize;
+} PackInput;
+
+static uint64_t AlignUp(uint64_t value)
+{
+    return (value + (PACK_ALIGNMENT - 1)) & ~(uint64_t)(PACK_ALIGNMENT - 1);
+}
+
+static bool WritePadding(FILE *out, uint64_t from, uint64_t to)
+{
+    static const unsigned char zeros[PACK_ALIGNMENT] = {0};
+    return (to == from) || fwrite(zeros, 1, (size_t)(to - from), out) == (size_t)(to - from);
+}
+
+int main(int argc, char **argv)
+{
+    const char *outputPath = (argc > 1) ? argv[1] : PACK_FILE_NAME;
+    const char *assetDir = (argc > 2) ? argv[2] : ".";
+    SetTraceLogLevel(LOG_WARNING);
+
+    PackInput inputs[PACK_MANIFEST_COUNT] = {0};
+    PackEntry entries[PACK_MANIFEST_COUNT] = {0};
+    int count = 0;
+    int missingRequired = 0;
+
+    for (int i = 0; i < PACK_MANIFEST_COUNT; i++) {
+        const PackManifestEntry *source = &PACK_MANIFEST[i];
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", assetDir, source->name);
+
+        if (strlen(source->name) >= PACK_NAME_LENGTH) {
+            fprintf(stderr, "error: asset name too long: %s\n", source->name);
+            return 1;
+        }
+
+        PackInput *input = &inputs[count];
+        input->source = source;
+        if (source->isImage) {
+            input->image = LoadImage(path);
+            if (input->image.data != NULL) ImageFormat(&input->image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        } else {
+            input->data = LoadFileData(path, &input->dataSize);
+        }
+
+        if (input->image.data == NULL && input->data == NULL) {
+            if (source->required) {
+                fprintf(stderr, "error: missing required asset %s\n", path);
+                missingRequired++;
+            } else {
+                fprintf(stderr, "warning: optional asset %s not found, skipped\n", path);
+            }
+            continue;
+        }
+        count++;
+    }
+
+    if (missingRequired > 0) {
+        fprintf(stderr, "%d required asset(s) missing, archive not written\n", missingRequired);
+        return 1;
+    }
+
+    uint64_t offset = AlignUp(sizeof(PackHeader) + sizeof(PackEntry) * count);
+    for (int i = 0; i < count; i++) {
+        PackInput *input = &inputs[i];
+        PackEntry *entry = &entries[i];
+        strncpy(entry->name, input->source->name, PACK_NAME_LENGTH - 1);
+        if (input->image.data != NULL) {
+            entry->kind = PACK_RGBA8;
+            entry->width = (uint32_t)input->image.width;
+            entry->height = (uint32_t)input->image.height;
+            entry->size = (uint64_t)input->image.width * input->image.height * 4;
+        } else {
+            entry->kind = PACK_RAW;
+            entry->size = (uint64_t)input->dataSize;
+        }
+        entry->offset = offset;
+        offset = AlignUp(offset + entry->size);
+    }
+
+    FILE *out = fopen(outputPath, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "error: cannot open %s for writing\n", outputPath);
+        return 1;
+    }
+
+    PackHeader header = {PACK_MAGIC, PACK_VERSION, (uint32_t)count, 0};
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(entries, sizeof(PackEntry), (size_t)count, out) == (size_t)count;
+    uint64_t written = sizeof(PackHeader) + sizeof(PackEntry) * count;
+
+    for (int i = 0; ok && i < count; i++) {
+        const void *payload = (inputs[i].image.data != NULL) ? inputs[i].image.data : (const void *)inputs[i].data;
+        ok = WritePadding(out, written, entries[i].offset) &&
+             fwrite(payload, 1, (size_t)entries[i].size, out) == (size_t)entries[i].size;
+        written = entries[i].offset + entries[i].size;
+        printf("%-24s %8llu bytes%s\n", entries[i].name, (unsigned long long)entries[i].size,
+               (entries[i].kind == PACK_RGBA8) ? " (rgba8)" : "");
+    }
+    ok = ok && WritePadding(out, written, AlignUp(written));
+    fclose(out);
+
+    for (int i = 0; i < count; i++) {
+        if (inputs[i].image.data != NULL) UnloadImage(inputs[i].image);
+        if (inputs[i].data != NULL) UnloadFileData(inputs[i].data);
+    }
+
+    if (!ok) {
+        fprintf(stderr, "error: failed writing %s\n", outputPath);
+        remove(outputPath);
+        return 1;
+    }
+    printf("Packed %d assets into %s (%llu bytes)\n", count, outputPath, (unsigned long long)offset);
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Aggregates telemetry streams recorded with `main.exe --telemetry <file>`.
+// Files are parsed in parallel; the output is one CSV row per file and a
+// protester density heatmap summed over every file.
+//
+// Usage: telemetry_report [-j threads] [-o prefix] file...
+//   writes <prefix>summary.csv and <prefix>heatmap.pgm (prefix defaults to "telemetry_")
+
+#include "../telemetry.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEAT_CELLS (TELEMETRY_HEAT_ROWS * TELEMETRY_HEAT_COLUMNS)
+#define MAX_THREADS 64
+
+typedef struct
+{
+    const char *path;
+    bool valid;
+    TelemetryHeader header;
+    uint32_t records;
+    uint32_t matches;
+    float duration;       // summed over matches
+    float peakMorale;
+    float meanControl;
+    float minPoliceHealth;
+    uint32_t finalAlive;  // at the last record
+    uint32_t finalArrested;
+    uint32_t peakProjectiles;
+    double meanTimings[TIMING_COUNT];
+    uint64_t heat[HEAT_CELLS];
+} FileSummary;
+
+typedef struct
+{
+    FileSummary *files;
+    int count;
+    atomic_int next;
+} ReportJob;
+
+static void SummarizeFile(FileSummary *summary)
+{
+    FILE *file = fopen(summary->path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "warning: cannot open %s\n", summary->path);
+        return;
+    }
+    if (fread(&summary->header, sizeof(TelemetryHeader), 1, file) != 1 ||
+        summary->header.magic != TELEMETRY_MAGIC || summary->header.version != TELEMETRY_VERSION) {
+        fprintf(stderr, "warning: %s is not a telemetry stream, skipped\n", summary->path);
+        fclose(file);
+        return;
+    }
+
+    TelemetryRecord record;
+    float lastTime = -1.0f;
+    double controlSum = 0.0;
+    summary->minPoliceHealth = -1.0f;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        if (record.time < lastTime || summary->records == 0) {
+            summary->matches++;
+        } else {
+            summary->duration += record.time - lastTime;
+        }
+        lastTime = record.time;
+        summary->records++;
+
+        if (summary->records == 1 || record.morale > summary->peakMorale) summary->peakMorale = record.morale;
+        if (summary->minPoliceHealth < 0.0f || record.policeHealth < summary->minPoliceHealth) {
+            summary->minPoliceHealth = record.policeHealth;
+        }
+        if (record.projectiles > summary->peakProjectiles) summary->peakProjectiles = record.projectiles;
+        controlSum += record.control;
+        for (int s = 0; s < TIMING_COUNT; s++) summary->meanTimings[s] += record.timings[s];
+        for (int c = 0; c < HEAT_CELLS; c++) summary->heat[c] += record.heat[c];
+
+        summary->finalAlive = 0;
+        for (int s = 0; s < TELEMETRY_STATE_COUNT - 1; s++) summary->finalAlive += record.stateCounts[s];
+        summary->finalArrested = record.stateCounts[TELEMETRY_STATE_COUNT - 1];
+    }
+    fclose(file);
+
+    if (summary->records > 0) {
+        summary->meanControl = (float)(controlSum / summary->records);
+        for (int s = 0; s < TIMING_COUNT; s++) summary->meanTimings[s] /= summary->records;
+    }
+    summary->valid = true;
+}
+
+static void *ReportWorker(void *arg)
+{
+    ReportJob *job = (ReportJob *)arg;
+    for (;;) {
+        int index = atomic_fetch_add(&job->next, 1);
+        if (index >= job->count) break;
+        SummarizeFile(&job->files[index]);
+    }
+    return NULL;
+}
+
+static bool WriteSummaryCsv(const char *path, const FileSummary *files, int count)
+{
+    FILE *out = fopen(path, "w");
+    if (out == NULL) return false;
+    fprintf(out, "file,protesters,police,world_width,records,matches,duration_s,peak_morale,mean_control,"
+                 "min_police_health,final_alive,final_arrested,peak_projectiles");
+    for (int s = 0; s < TIMING_COUNT; s++) fprintf(out, ",%s_ms", TELEMETRY_TIMING_NAMES[s]);
+    fprintf(out, "\n");
+
+    for (int i = 0; i < count; i++) {
+        const FileSummary *f = &files[i];
+        if (!f->valid) continue;
+        fprintf(out, "%s,%u,%u,%u,%u,%u,%.1f,%.2f,%.3f,%.1f,%u,%u,%u", f->path,
+                f->header.maxProtesters, f->header.maxPolice, f->header.worldWidth,
+                f->records, f->matches, f->duration, f->peakMorale, f->meanControl,
+                f->minPoliceHealth, f->finalAlive, f->finalArrested, f->peakProjectiles);
+        for (int s = 0; s < TIMING_COUNT; s++) fprintf(out, ",%.3f", f->meanTimings[s]);
+        fprintf(out, "\n");
+    }
+    fclose(out);
+    return true;
+}
+
+// Plain-text PGM, one pixel per grid cell, brightest where protesters spent
+// the most samples
+static bool WriteHeatmap(const char *path, const FileSummary *files, int count)
+{
+    uint64_t total[HEAT_CELLS] = {0};
+    uint64_t peak = 0;
+    for (int i = 0; i < count; i++) {
+        if (!files[i].valid) continue;
+        for (int c = 0; c < HEAT_CELLS; c++) total[c] += files[i].heat[c];
+    }
+    for (int c = 0; c < HEAT_CELLS; c++) {
+        if (total[c] > peak) peak = total[c];
+    }
+
+    FILE *out = fopen(path, "w");
+    if (out == NULL) return false;
+    fprintf(out, "P2\n%d %d\n255\n", TELEMETRY_HEAT_COLUMNS, TELEMETRY_HEAT_ROWS);
+    for (int row = 0; row < TELEMETRY_HEAT_ROWS; row++) {
+        for (int col = 0; col < TELEMETRY_HEAT_COLUMNS; col++) {
+            uint64_t value = total[row * TELEMETRY_HEAT_COLUMNS + col];
+            fprintf(out, "%d ", (peak > 0) ? (int)(value * 255 / peak) : 0);
+        }
+        fprintf(out, "\n");
+    }
+    fclose(out);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 8;
+    const char *prefix = "telemetry_";
+    int first = 1;
+    while (first + 1 < argc && argv[first][0] == '-') {
+        if (strcmp(argv[first], "-j") == 0) threads = atoi(argv[first + 1]);
+        else if (strcmp(argv[first], "-o") == 0) prefix = argv[first + 1];
+        else break;
+        first += 2;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "usage: %s [-j threads] [-o prefix] file...\n", argv[0]);
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    ReportJob job = {0};
+    job.count = argc - first;
+    job.files = calloc((size_t)job.count, sizeof(FileSummary));
+    if (job.files == NULL) {
+        fprintf(stderr, "error: out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < job.count; i++) job.files[i].path = argv[first + i];
+    atomic_init(&job.next, 0);
+
+    if (threads > job.count) threads = job.count;
+    pthread_t workers[MAX_THREADS];
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, ReportWorker, &job) != 0) break;
+    }
+    if (started == 0) ReportWorker(&job);
+    for (int i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+    int valid = 0;
+    for (int i = 0; i < job.count; i++) valid += job.files[i].valid ? 1 : 0;
+
+    char csvPath[512];
+    char heatPath[512];
+    snprintf(csvPath, sizeof(csvPath), "%ssummary.csv", prefix);
+    snprintf(heatPath, sizeof(heatPath), "%sheatmap.pgm", prefix);
+    bool ok = WriteSummaryCsv(csvPath, job.files, job.count) && WriteHeatmap(heatPath, job.files, job.count);
+    free(job.files);
+    if (!ok) {
+        fprintf(stderr, "error: could not write %s or %s\n", csvPath, heatPath);
+        return 1;
+    }
+    printf("%d of %d file(s) summarized into %s and %s\n", valid, job.count, csvPath, heatPath);
+    return 0;
+}